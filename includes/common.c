@@ -53,6 +53,23 @@ char *create_json_payload(const dht_data_t *data)
     cJSON_AddStringToObject(root, "humidity", humStr);
     cJSON_AddStringToObject(root, "timestamp", data->timestamp);
 
+#if PSYCHRO_METRICS_ENABLED
+    char dewStr[8], absHumStr[8], heatStr[8];
+    // Omitted outside their tables instead of reporting a clamped value
+    if (data->psychro.dew_point_valid)
+    {
+        sprintf(dewStr, "%.2f", data->psychro.dew_point / 100.0f);
+        cJSON_AddStringToObject(root, "dew_point", dewStr);
+    }
+    sprintf(absHumStr, "%.2f", data->psychro.abs_humidity / 100.0f);
+    cJSON_AddStringToObject(root, "abs_humidity", absHumStr);
+    if (data->psychro.heat_index_valid)
+    {
+        sprintf(heatStr, "%.2f", data->psychro.heat_index / 100.0f);
+        cJSON_AddStringToObject(root, "heat_index", heatStr);
+    }
+#endif
+
     // Convert to string
     char *json_str = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
@@ -6,7 +6,7 @@
 #include "cJSON.h"
 #include "esp_log.h"
 
-#define MEASURE_INTERVAL 60 * 1000
+#define MEASURE_INTERVAL 60 * 1000 // Initial sampling period, adapted at runtime by sampling_manager
 #define WIFI_RECONNECT_INTERVAL_MS 60 * 1000
 #define TIMER_ID 1
 #define STACK_SIZE 4 * 1024
@@ -40,7 +40,8 @@ void get_current_date_time(char *date_time);
  * 
  * This function takes DHT sensor data (temperature, humidity, timestamp) and
  * creates a JSON formatted string suitable for transmission via MQTT or other
- * communication protocols.
+ * communication protocols. When PSYCHRO_METRICS_ENABLED is set, the dew point,
+ * absolute humidity and heat index are added as optional fields.
  * 
  * @param data Pointer to a dht_data_t structure containing sensor readings
  *             and timestamp information
@@ -2,6 +2,7 @@
 #define DHT_SENSOR_H
 
 #include "dht.h"
+#include "psychro_manager.h"
 
 #define CONFIG_EXAMPLE_INTERNAL_PULLUP 0
 #define CONFIG_EXAMPLE_TYPE_DHT11 0
@@ -12,13 +13,15 @@
  * @brief Structure to hold DHT sensor data with timestamp
  * 
  * This structure contains temperature and humidity readings from a DHT sensor
- * along with an ISO 8601 formatted timestamp indicating when the reading was taken.
+ * along with an ISO 8601 formatted timestamp indicating when the reading was taken
+ * and the psychrometric values derived from the reading.
  */
 typedef struct
 {
     float temperature;              /**< Temperature reading in degrees Celsius */
     float humidity;                 /**< Relative humidity reading in percentage (0-100%) */
     char timestamp[ISO8601_STR_LEN]; /**< ISO 8601 format timestamp (YYYY-MM-DDTHH:MM:SSZ) */
+    psychro_data_t psychro;          /**< Dew point, absolute humidity and heat index (fixed point) */
 } dht_data_t;
 
 /**
@@ -0,0 +1,391 @@
+#include "http_manager.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "common.h"
+#include "mqtt_manager.h"
+#include "mqttsn_manager.h"
+#include "sampling_manager.h"
+
+static const char *TAG = "HTTP Metrics";
+
+/**
+ * @brief One pre-rendered copy of both response bodies
+ */
+typedef struct
+{
+    char prom[HTTP_PROM_BUF_SIZE];
+    size_t prom_len;
+    char json[HTTP_JSON_BUF_SIZE];
+    size_t json_len;
+} rendered_metrics_t;
+
+/*
+ * Double buffer: requests are served from s_rendered[s_front] while the
+ * render task writes into the other one. s_readers counts the requests
+ * still sending from each buffer, the renderer waits for the back buffer
+ * to be released before overwriting it.
+ */
+static rendered_metrics_t s_rendered[2];
+static int s_front = 0;
+static uint32_t s_readers[2];
+static portMUX_TYPE s_buffer_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static dht_data_t s_history[HTTP_HISTORY_LEN];
+static size_t s_history_count = 0;
+static size_t s_history_next = 0;
+static uint32_t s_counters[METRIC_COUNT];
+static portMUX_TYPE s_data_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static httpd_handle_t s_server = NULL;
+static TaskHandle_t s_render_task = NULL;
+
+static const char *counter_names[METRIC_COUNT] = {
+    [METRIC_SAMPLES] = "samples",
+    [METRIC_READ_ERRORS] = "read_errors",
+    [METRIC_QUEUE_DROPS] = "queue_drops",
+    [METRIC_PUBLISHED] = "published",
+    [METRIC_PUBLISH_ERRORS] = "publish_errors",
+};
+
+static void append(char *buf, size_t size, size_t *pos, const char *fmt, ...)
+{
+    if (*pos >= size)
+    {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + *pos, size - *pos, fmt, args);
+    va_end(args);
+    if (n > 0)
+    {
+        *pos += n;
+    }
+}
+
+static double round2(float value)
+{
+    // Avoid printing float artifacts such as 23.399999618530273
+    return round(value * 100.0) / 100.0;
+}
+
+/* One series per broker endpoint, labelled with its index and role; the TLS slot is the endpoint index */
+static void render_endpoints(char *buf, size_t size, size_t *pos)
+{
+    static const char *const endpoint_gauges[] = {"connected", "healthy", "failover_last_seconds", "failover_max_seconds"};
+    static const char *const endpoint_counters[] = {"published", "publish_errors", "queue_drops", "failovers", "disconnects"};
+    enum { N_GAUGES = sizeof(endpoint_gauges) / sizeof(endpoint_gauges[0]), N_COUNTERS = sizeof(endpoint_counters) / sizeof(endpoint_counters[0]) };
+
+    int count = mqtt_endpoint_count();
+    const char *roles[MQTT_MAX_ENDPOINTS];
+    double gauges[MQTT_MAX_ENDPOINTS][N_GAUGES];
+    uint32_t counters[MQTT_MAX_ENDPOINTS][N_COUNTERS];
+    tls_handshake_stats_t tls[MQTT_MAX_ENDPOINTS];
+    for (int i = 0; i < count; i++)
+    {
+        mqtt_role_t role;
+        mqtt_endpoint_stats_t stats;
+        mqtt_get_endpoint_stats(i, &role, &stats);
+        roles[i] = mqtt_role_name(role);
+        gauges[i][0] = stats.connected;
+        gauges[i][1] = stats.healthy;
+        gauges[i][2] = stats.last_failover_us / 1e6;
+        gauges[i][3] = stats.max_failover_us / 1e6;
+        counters[i][0] = stats.published;
+        counters[i][1] = stats.publish_errors;
+        counters[i][2] = stats.queue_drops;
+        counters[i][3] = stats.failovers;
+        counters[i][4] = stats.disconnects;
+        tls_get_stats(i, &tls[i]);
+    }
+
+    // Prometheus wants all the series of a metric right after its TYPE line
+    for (int g = 0; g < N_GAUGES; g++)
+    {
+        append(buf, size, pos, "# TYPE env_mqtt_endpoint_%s gauge\n", endpoint_gauges[g]);
+        for (int i = 0; i < count; i++)
+        {
+            append(buf, size, pos, "env_mqtt_endpoint_%s{endpoint=\"%d\",role=\"%s\"} %.3f\n",
+                   endpoint_gauges[g], i, roles[i], gauges[i][g]);
+        }
+    }
+    for (int c = 0; c < N_COUNTERS; c++)
+    {
+        append(buf, size, pos, "# TYPE env_mqtt_endpoint_%s_total counter\n", endpoint_counters[c]);
+        for (int i = 0; i < count; i++)
+        {
+            append(buf, size, pos, "env_mqtt_endpoint_%s_total{endpoint=\"%d\",role=\"%s\"} %lu\n",
+                   endpoint_counters[c], i, roles[i], (unsigned long)counters[i][c]);
+        }
+    }
+
+    append(buf, size, pos, "# TYPE env_tls_handshakes_total counter\n");
+    for (int i = 0; i < count; i++)
+    {
+        append(buf, size, pos, "env_tls_handshakes_total{endpoint=\"%d\",type=\"full\"} %lu\n", i, (unsigned long)tls[i].full_handshakes);
+        append(buf, size, pos, "env_tls_handshakes_total{endpoint=\"%d\",type=\"resumed\"} %lu\n", i, (unsigned long)tls[i].resumed_handshakes);
+        append(buf, size, pos, "env_tls_handshakes_total{endpoint=\"%d\",type=\"failed\"} %lu\n", i, (unsigned long)tls[i].failed_handshakes);
+    }
+    append(buf, size, pos, "# TYPE env_tls_handshake_seconds_sum counter\n");
+    for (int i = 0; i < count; i++)
+    {
+        append(buf, size, pos, "env_tls_handshake_seconds_sum{endpoint=\"%d\",type=\"full\"} %.3f\n", i, tls[i].full_total_us / 1e6);
+        append(buf, size, pos, "env_tls_handshake_seconds_sum{endpoint=\"%d\",type=\"resumed\"} %.3f\n", i, tls[i].resumed_total_us / 1e6);
+    }
+}
+
+static void render_prometheus(rendered_metrics_t *out, const dht_data_t *latest, bool has_sample,
+                              const uint32_t *counters)
+{
+    char *buf = out->prom;
+    size_t size = sizeof(out->prom);
+    size_t pos = 0;
+
+    if (has_sample)
+    {
+        append(buf, size, &pos, "# TYPE env_temperature_celsius gauge\nenv_temperature_celsius %.2f\n", latest->temperature);
+        append(buf, size, &pos, "# TYPE env_humidity_percent gauge\nenv_humidity_percent %.2f\n", latest->humidity);
+    }
+    for (int i = 0; i < METRIC_COUNT; i++)
+    {
+        append(buf, size, &pos, "# TYPE env_%s_total counter\nenv_%s_total %lu\n",
+               counter_names[i], counter_names[i], (unsigned long)counters[i]);
+    }
+    append(buf, size, &pos, "# TYPE env_sampling_interval_ms gauge\nenv_sampling_interval_ms %lu\n",
+           (unsigned long)sampling_current_interval());
+
+    render_endpoints(buf, size, &pos);
+
+    mqttsn_stats_t sn;
+    mqttsn_get_stats(&sn);
+    append(buf, size, &pos, "# TYPE env_mqttsn_retransmits_total counter\nenv_mqttsn_retransmits_total %lu\n",
+           (unsigned long)sn.retransmits);
+    append(buf, size, &pos, "# TYPE env_mqttsn_bytes_sent_total counter\nenv_mqttsn_bytes_sent_total %lu\n",
+           (unsigned long)sn.bytes_sent);
+
+    append(buf, size, &pos, "# TYPE env_free_heap_bytes gauge\nenv_free_heap_bytes %lu\n",
+           (unsigned long)esp_get_free_heap_size());
+    append(buf, size, &pos, "# TYPE env_uptime_seconds gauge\nenv_uptime_seconds %lld\n",
+           esp_timer_get_time() / 1000000);
+
+    if (pos >= size)
+    {
+        ESP_LOGW(TAG, "Prometheus buffer too small, output truncated");
+        pos = size - 1;
+    }
+    out->prom_len = pos;
+}
+
+static void render_json(rendered_metrics_t *out, const dht_data_t *history, size_t count, const uint32_t *counters)
+{
+    cJSON *root = cJSON_CreateObject();
+
+    if (count > 0)
+    {
+        const dht_data_t *latest = &history[count - 1];
+        cJSON *sample = cJSON_AddObjectToObject(root, "latest");
+        cJSON_AddNumberToObject(sample, "temperature", round2(latest->temperature));
+        cJSON_AddNumberToObject(sample, "humidity", round2(latest->humidity));
+        cJSON_AddStringToObject(sample, "timestamp", latest->timestamp);
+    }
+
+    cJSON *list = cJSON_AddArrayToObject(root, "history");
+    for (size_t i = 0; i < count; i++)
+    {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "temperature", round2(history[i].temperature));
+        cJSON_AddNumberToObject(item, "humidity", round2(history[i].humidity));
+        cJSON_AddStringToObject(item, "timestamp", history[i].timestamp);
+        cJSON_AddItemToArray(list, item);
+    }
+
+    cJSON *stats = cJSON_AddObjectToObject(root, "counters");
+    for (int i = 0; i < METRIC_COUNT; i++)
+    {
+        cJSON_AddNumberToObject(stats, counter_names[i], counters[i]);
+    }
+    cJSON_AddNumberToObject(root, "sampling_interval_ms", sampling_current_interval());
+    cJSON_AddNumberToObject(root, "free_heap", esp_get_free_heap_size());
+    cJSON_AddNumberToObject(root, "uptime_s", (double)(esp_timer_get_time() / 1000000));
+
+    if (cJSON_PrintPreallocated(root, out->json, sizeof(out->json), false))
+    {
+        out->json_len = strlen(out->json);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "JSON buffer too small");
+        out->json_len = snprintf(out->json, sizeof(out->json), "{\"error\":\"buffer too small\"}");
+    }
+    cJSON_Delete(root);
+}
+
+static void render_metrics(void)
+{
+    dht_data_t history[HTTP_HISTORY_LEN];
+    uint32_t counters[METRIC_COUNT];
+    size_t count;
+
+    // Snapshot the shared data in chronological order
+    taskENTER_CRITICAL(&s_data_lock);
+    count = s_history_count;
+    size_t first = (s_history_next + HTTP_HISTORY_LEN - count) % HTTP_HISTORY_LEN;
+    for (size_t i = 0; i < count; i++)
+    {
+        history[i] = s_history[(first + i) % HTTP_HISTORY_LEN];
+    }
+    memcpy(counters, s_counters, sizeof(counters));
+    taskEXIT_CRITICAL(&s_data_lock);
+
+    // Wait until no request is still sending from the back buffer
+    int back;
+    while (true)
+    {
+        taskENTER_CRITICAL(&s_buffer_lock);
+        back = 1 - s_front;
+        uint32_t readers = s_readers[back];
+        taskEXIT_CRITICAL(&s_buffer_lock);
+        if (readers == 0)
+        {
+            break;
+        }
+        vTaskDelay(1);
+    }
+
+    rendered_metrics_t *out = &s_rendered[back];
+    render_prometheus(out, count > 0 ? &history[count - 1] : NULL, count > 0, counters);
+    render_json(out, history, count, counters);
+
+    taskENTER_CRITICAL(&s_buffer_lock);
+    s_front = back;
+    taskEXIT_CRITICAL(&s_buffer_lock);
+}
+
+static void task_render_metrics(void *args)
+{
+    while (true)
+    {
+        render_metrics();
+        // Uptime, heap and broker health change without any notification
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HTTP_REFRESH_MS));
+    }
+}
+
+static esp_err_t serve_rendered(httpd_req_t *req, bool json)
+{
+    taskENTER_CRITICAL(&s_buffer_lock);
+    int front = s_front;
+    s_readers[front]++;
+    taskEXIT_CRITICAL(&s_buffer_lock);
+
+    const rendered_metrics_t *rendered = &s_rendered[front];
+    esp_err_t res;
+    if (json)
+    {
+        httpd_resp_set_type(req, "application/json");
+        res = httpd_resp_send(req, rendered->json, rendered->json_len);
+    }
+    else
+    {
+        httpd_resp_set_type(req, "text/plain; version=0.0.4");
+        res = httpd_resp_send(req, rendered->prom, rendered->prom_len);
+    }
+
+    taskENTER_CRITICAL(&s_buffer_lock);
+    s_readers[front]--;
+    taskEXIT_CRITICAL(&s_buffer_lock);
+    return res;
+}
+
+static esp_err_t metrics_prometheus_handler(httpd_req_t *req)
+{
+    return serve_rendered(req, false);
+}
+
+static esp_err_t metrics_json_handler(httpd_req_t *req)
+{
+    return serve_rendered(req, true);
+}
+
+esp_err_t setup_http(void)
+{
+    if (s_server != NULL)
+    {
+        return ESP_OK;
+    }
+
+    if (xTaskCreate(task_render_metrics, "Render metrics", STACK_SIZE, NULL, 1, &s_render_task) != pdPASS)
+    {
+        return ESP_FAIL;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = HTTP_METRICS_PORT;
+    config.lru_purge_enable = true;
+
+    esp_err_t res = httpd_start(&s_server, &config);
+    if (res != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error starting HTTP server: %s", esp_err_to_name(res));
+        return res;
+    }
+
+    const httpd_uri_t prometheus_uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_prometheus_handler,
+    };
+    const httpd_uri_t json_uri = {
+        .uri = "/metrics.json",
+        .method = HTTP_GET,
+        .handler = metrics_json_handler,
+    };
+    httpd_register_uri_handler(s_server, &prometheus_uri);
+    httpd_register_uri_handler(s_server, &json_uri);
+
+    ESP_LOGI(TAG, "Metrics served on port %d", HTTP_METRICS_PORT);
+    return ESP_OK;
+}
+
+void http_metrics_record_sample(const dht_data_t *data)
+{
+    taskENTER_CRITICAL(&s_data_lock);
+    s_history[s_history_next] = *data;
+    s_history_next = (s_history_next + 1) % HTTP_HISTORY_LEN;
+    if (s_history_count < HTTP_HISTORY_LEN)
+    {
+        s_history_count++;
+    }
+    taskEXIT_CRITICAL(&s_data_lock);
+
+    if (s_render_task != NULL)
+    {
+        xTaskNotifyGive(s_render_task);
+    }
+}
+
+void http_metrics_inc(metric_counter_t counter)
+{
+    if (counter >= METRIC_COUNT)
+    {
+        return;
+    }
+    taskENTER_CRITICAL(&s_data_lock);
+    s_counters[counter]++;
+    taskEXIT_CRITICAL(&s_data_lock);
+
+    if (s_render_task != NULL)
+    {
+        xTaskNotifyGive(s_render_task);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef HTTP_MANAGER_H
+#define HTTP_MANAGER_H
+
+#include "dht_manager.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+
+#define HTTP_METRICS_ENABLED 0      /**< 1 to serve /metrics and /metrics.json over HTTP (unauthenticated) */
+#define HTTP_METRICS_PORT 80        /**< TCP port of the metrics endpoint */
+#define HTTP_HISTORY_LEN 16         /**< Number of recent samples exposed in /metrics.json */
+#define HTTP_PROM_BUF_SIZE 5120     /**< Size of each pre-rendered Prometheus buffer */
+#define HTTP_JSON_BUF_SIZE 2560     /**< Size of each pre-rendered JSON buffer */
+#define HTTP_REFRESH_MS (10 * 1000) /**< Re-render period for gauges that change without a new sample */
+
+/**
+ * @brief Internal counters exposed by the metrics endpoint
+ */
+typedef enum
+{
+    METRIC_SAMPLES,          /**< Successful sensor readings */
+    METRIC_READ_ERRORS,      /**< Failed sensor readings */
+    METRIC_QUEUE_DROPS,      /**< Samples that did not fit in the display or MQTT queue */
+    METRIC_PUBLISHED,        /**< Samples handed to the publish transport */
+    METRIC_PUBLISH_ERRORS,   /**< Samples the publish transport rejected or skipped */
+    METRIC_COUNT
+} metric_counter_t;
+
+/**
+ * @fn esp_err_t setup_http(void)
+ * @brief Starts the HTTP server exposing the station metrics
+ *
+ * Two endpoints are registered: /metrics (Prometheus text format) and
+ * /metrics.json (latest sample, recent history and counters). Both bodies
+ * are rendered by a background task into a double-buffered static buffer
+ * each time a new sample is recorded, and requests are answered directly
+ * from the front buffer without formatting or copying anything, so
+ * frequent scrapes cost almost nothing.
+ *
+ * @return ESP_OK on success, or the error returned by esp_http_server
+ */
+esp_err_t setup_http(void);
+
+/**
+ * @fn void http_metrics_record_sample(const dht_data_t *data)
+ * @brief Adds a sample to the history and schedules a re-render of the buffers
+ *
+ * Cheap enough to be called from the measurement timer callback. Before
+ * setup_http() has been called the sample is only stored.
+ *
+ * @param data Pointer to the latest successful sensor reading
+ */
+void http_metrics_record_sample(const dht_data_t *data);
+
+/**
+ * @fn void http_metrics_inc(metric_counter_t counter)
+ * @brief Increments one of the internal counters
+ *
+ * Schedules a re-render of the buffers, so failures are visible even
+ * while no new sample is recorded.
+ *
+ * @param counter Counter to increment
+ */
+void http_metrics_inc(metric_counter_t counter);
+
+#endif
@@ -1,27 +1,102 @@
 #include "mqtt_manager.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 
-bool MQTT_CONNECTED = false;
-esp_mqtt_client_handle_t client = NULL;
+#include "common.h"
+
+#ifdef MQTT_BROKER_CA_EMBEDDED
+extern const char broker_ca_pem_start[] asm("_binary_broker_ca_pem_start");
+#endif
+
+_Static_assert(MQTT_MAX_ENDPOINTS <= TLS_SESSION_SLOTS, "every endpoint needs its own TLS session slot");
+_Static_assert(MQTT_FAILOVER_HOLDOFF_MS > MQTT_RECONNECT_MS, "the primary must get a reconnect attempt before failing over");
+
+/**
+ * @brief Runtime state of a broker endpoint
+ */
+typedef struct
+{
+    const char *uri;
+    char client_id[MQTT_CLIENT_ID_LEN];
+    mqtt_role_t role;
+    uint8_t index;
+    esp_mqtt_client_handle_t client;
+    QueueHandle_t queue;
+    mqtt_endpoint_stats_t stats;
+    uint8_t consecutive_errors;
+    int64_t unhealthy_since;    // esp_timer time the endpoint stopped being healthy, 0 while healthy
+    int64_t lost_since;         // Last transition from healthy to unhealthy, 0 if never healthy since boot
+    int64_t takeover_since;     // Primary loss being measured on this endpoint, 0 when none
+} mqtt_endpoint_t;
+
+bool MQTT_CONNECTED = false;    // At least one endpoint is connected
+
+static mqtt_endpoint_t s_endpoints[MQTT_MAX_ENDPOINTS];
+static int s_endpoint_count = 0;
+static int s_active = 0;        // Endpoint currently receiving the failover traffic
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Must be called with s_lock held */
+static void update_health(mqtt_endpoint_t *ep)
+{
+    bool healthy = ep->stats.connected && ep->consecutive_errors < MQTT_UNHEALTHY_ERRORS;
+    if (ep->stats.healthy && !healthy)
+    {
+        ep->unhealthy_since = esp_timer_get_time();
+        ep->lost_since = ep->unhealthy_since;
+    }
+    else if (healthy)
+    {
+        ep->unhealthy_since = 0;
+    }
+    ep->stats.healthy = healthy;
+
+    bool any = false;
+    for (int i = 0; i < s_endpoint_count; i++)
+    {
+        any |= s_endpoints[i].stats.connected;
+    }
+    MQTT_CONNECTED = any;
+}
 
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
 {
     const char *TAG = "MQTT_EVENT_HANDLER";
+    mqtt_endpoint_t *ep = handler_args;
     esp_mqtt_event_handle_t event = event_data;
     esp_mqtt_client_handle_t client = event->client;
     int msg_id;
     switch ((esp_mqtt_event_id_t)event_id)
     {
     case MQTT_EVENT_CONNECTED:
-        ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
-        MQTT_CONNECTED = true;
+        ESP_LOGI(TAG, "[%s] MQTT_EVENT_CONNECTED, session_present=%d", mqtt_role_name(ep->role), event->session_present);
+        taskENTER_CRITICAL(&s_lock);
+        ep->stats.connected = true;
+        ep->stats.connects++;
+        ep->consecutive_errors = 0;
+        update_health(ep);
+        taskEXIT_CRITICAL(&s_lock);
 
-        msg_id = esp_mqtt_client_subscribe(client, "/home/office/dht", 0);
-        ESP_LOGI(TAG, "sent subscribe successful, msg_id=%d", msg_id);
+        // The broker keeps the subscriptions of a persistent session
+        if (!event->session_present)
+        {
+            msg_id = esp_mqtt_client_subscribe(client, MQTT_SAMPLE_TOPIC, 0);
+            ESP_LOGI(TAG, "sent subscribe successful, msg_id=%d", msg_id);
+        }
         break;
     case MQTT_EVENT_DISCONNECTED:
-        ESP_LOGW(TAG, "MQTT_EVENT_DISCONNECTED");
-        MQTT_CONNECTED = false;
+        ESP_LOGW(TAG, "[%s] MQTT_EVENT_DISCONNECTED", mqtt_role_name(ep->role));
+        taskENTER_CRITICAL(&s_lock);
+        ep->stats.connected = false;
+        ep->stats.disconnects++;
+        update_health(ep);
+        taskEXIT_CRITICAL(&s_lock);
         break;
 
     case MQTT_EVENT_SUBSCRIBED:
@@ -34,11 +109,11 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
         ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
         break;
     case MQTT_EVENT_DATA:
-        ESP_LOGI(TAG, "TOPIC=%.*s", event->topic_len, event->topic);
+        ESP_LOGI(TAG, "[%s] TOPIC=%.*s", mqtt_role_name(ep->role), event->topic_len, event->topic);
         ESP_LOGI(TAG, "DATA=%.*s", event->data_len, event->data);
         break;
     case MQTT_EVENT_ERROR:
-        ESP_LOGI(TAG, "MQTT_EVENT_ERROR");
+        ESP_LOGI(TAG, "[%s] MQTT_EVENT_ERROR", mqtt_role_name(ep->role));
         break;
     default:
         ESP_LOGI(TAG, "Other event id:%d", event->event_id);
@@ -46,15 +121,299 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     }
 }
 
-void setup_mqtt(void)
-{   
+/**
+ * @brief Publishes the samples queued for one endpoint
+ *
+ * esp_mqtt_client_publish() copies the payload into the client's outgoing
+ * buffer, so the reference is released right after the call returns.
+ */
+static void task_publish_endpoint(void *args)
+{
+    const char *TAG = "MQTT endpoint";
+    mqtt_endpoint_t *ep = args;
+    shared_payload_t *payload;
+
+    while (true)
+    {
+        if (xQueueReceive(ep->queue, &payload, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+        int msg_id = esp_mqtt_client_publish(ep->client, MQTT_SAMPLE_TOPIC, payload->data, payload->len, 0, 0);
+        shared_payload_release(payload);
+
+        int64_t latency = 0;
+        taskENTER_CRITICAL(&s_lock);
+        if (msg_id >= 0)
+        {
+            ep->stats.published++;
+            ep->consecutive_errors = 0;
+            if (ep->takeover_since != 0)
+            {
+                latency = esp_timer_get_time() - ep->takeover_since;
+                ep->takeover_since = 0;
+                ep->stats.last_failover_us = latency;
+                if (latency > ep->stats.max_failover_us)
+                {
+                    ep->stats.max_failover_us = latency;
+                }
+            }
+        }
+        else
+        {
+            ep->stats.publish_errors++;
+            if (ep->consecutive_errors < UINT8_MAX)
+            {
+                ep->consecutive_errors++;
+            }
+        }
+        update_health(ep);
+        taskEXIT_CRITICAL(&s_lock);
+
+        if (msg_id < 0)
+        {
+            ESP_LOGW(TAG, "[%s] %s: publish failed (%d)", mqtt_role_name(ep->role), ep->uri, msg_id);
+        }
+        else if (latency != 0)
+        {
+            ESP_LOGW(TAG, "[%s] %s took over from the primary, failover latency %lld ms",
+                     mqtt_role_name(ep->role), ep->uri, latency / 1000);
+        }
+    }
+}
+
+static esp_err_t add_endpoint(const char *uri, mqtt_role_t role, const char *device_id)
+{
     const char *TAG = "Setup MQTT";
-    ESP_LOGI(TAG, "STARTING MQTT");
+    if (uri == NULL || uri[0] == '\0')
+    {
+        return ESP_OK;
+    }
+    if (s_endpoint_count >= MQTT_MAX_ENDPOINTS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    mqtt_endpoint_t *ep = &s_endpoints[s_endpoint_count];
+    ep->uri = uri;
+    ep->role = role;
+    ep->index = s_endpoint_count;
+    // Unique per endpoint, a broker drops the older of two sessions sharing an ID
+    if (role == MQTT_ROLE_PRIMARY)
+    {
+        snprintf(ep->client_id, sizeof(ep->client_id), "%s", device_id);
+    }
+    else
+    {
+        snprintf(ep->client_id, sizeof(ep->client_id), "%s_%s", device_id, mqtt_role_name(role));
+    }
+    // Not healthy until connected: the hold-off runs from boot, but this is not a loss
+    ep->unhealthy_since = esp_timer_get_time();
+    ep->lost_since = 0;
+
     esp_mqtt_client_config_t mqttConfig = {
-        .broker.address.uri = CONFIG_BROKER_URI,
+        .broker.address.uri = uri,
+        .credentials.client_id = ep->client_id,
+        .session.disable_clean_session = true,
+        .network.reconnect_timeout_ms = MQTT_RECONNECT_MS,
     };
 
-    client = esp_mqtt_client_init(&mqttConfig);
-    esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, client);
-    esp_mqtt_client_start(client);
-}
\ No newline at end of file
+    if (strncmp(uri, MQTT_TLS_SCHEME, strlen(MQTT_TLS_SCHEME)) == 0)
+    {
+#ifdef MQTT_BROKER_CA_EMBEDDED
+        const char *ca_pem = broker_ca_pem_start;
+#else
+        const char *ca_pem = NULL;
+#endif
+        mqttConfig.network.transport = tls_transport_create(ep->index, ca_pem);
+        if (mqttConfig.network.transport == NULL)
+        {
+            ESP_LOGE(TAG, "TLS transport for %s could not be created", uri);
+            return ESP_FAIL;
+        }
+    }
+
+    ep->queue = xQueueCreate(MQTT_ENDPOINT_QUEUE_LEN, sizeof(shared_payload_t *));
+    ep->client = esp_mqtt_client_init(&mqttConfig);
+    if (ep->queue == NULL || ep->client == NULL)
+    {
+        ESP_LOGE(TAG, "Endpoint %s could not be created", uri);
+        return ESP_FAIL;
+    }
+    if (xTaskCreate(task_publish_endpoint, "MQTT endpoint", STACK_SIZE, ep, 1, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Publish task for %s could not be created", uri);
+        return ESP_FAIL;
+    }
+
+    // Counted before starting so the event handler already sees it
+    s_endpoint_count++;
+    esp_mqtt_client_register_event(ep->client, ESP_EVENT_ANY_ID, mqtt_event_handler, ep);
+    esp_mqtt_client_start(ep->client);
+    ESP_LOGI(TAG, "Endpoint %d: %s (%s, client ID %s)", ep->index, uri, mqtt_role_name(role), ep->client_id);
+    return ESP_OK;
+}
+
+void setup_mqtt(void)
+{
+    const char *TAG = "Setup MQTT";
+    ESP_LOGI(TAG, "STARTING MQTT");
+
+    // A stable client ID is required for the broker to find the persistent session
+    char device_id[MQTT_CLIENT_ID_LEN];
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(device_id, sizeof(device_id), MQTT_CLIENT_ID_PREFIX "%02x%02x%02x", mac[3], mac[4], mac[5]);
+
+    // The primary must be endpoint 0, mqtt_publish_shared() relies on it
+    if (add_endpoint(CONFIG_BROKER_URI, MQTT_ROLE_PRIMARY, device_id) != ESP_OK || s_endpoint_count == 0)
+    {
+        ESP_LOGE(TAG, "Primary broker endpoint could not be started");
+        return;
+    }
+    add_endpoint(MQTT_SECONDARY_BROKER_URI, MQTT_ROLE_SECONDARY, device_id);
+    add_endpoint(MQTT_MIRROR_BROKER_URI, MQTT_ROLE_MIRROR, device_id);
+}
+
+shared_payload_t *shared_payload_create(char *data)
+{
+    if (data == NULL)
+    {
+        return NULL;
+    }
+    shared_payload_t *payload = malloc(sizeof(shared_payload_t));
+    if (payload == NULL)
+    {
+        free(data);
+        return NULL;
+    }
+    atomic_init(&payload->refs, 1);
+    payload->len = strlen(data);
+    payload->data = data;
+    return payload;
+}
+
+void shared_payload_release(shared_payload_t *payload)
+{
+    if (payload != NULL && atomic_fetch_sub(&payload->refs, 1) == 1)
+    {
+        free(payload->data);
+        free(payload);
+    }
+}
+
+esp_err_t mqtt_publish_shared(shared_payload_t *payload)
+{
+    const char *TAG = "MQTT publish";
+    if (payload == NULL || s_endpoint_count == 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    mqtt_endpoint_t *targets[MQTT_MAX_ENDPOINTS];
+    int n_targets = 0;
+    int previous_active;
+    int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&s_lock);
+    mqtt_endpoint_t *primary = &s_endpoints[0];
+    previous_active = s_active;
+    int next_active = 0;
+
+    if (!primary->stats.healthy && now - primary->unhealthy_since >= (int64_t)MQTT_FAILOVER_HOLDOFF_MS * 1000)
+    {
+        for (int i = 1; i < s_endpoint_count; i++)
+        {
+            if (s_endpoints[i].role == MQTT_ROLE_SECONDARY && s_endpoints[i].stats.healthy)
+            {
+                next_active = i;
+                break;
+            }
+        }
+    }
+    if (next_active != s_active && next_active != 0)
+    {
+        s_endpoints[next_active].stats.failovers++;
+        // Measured from the primary's last loss, a boot without primary is not timed
+        s_endpoints[next_active].takeover_since = primary->lost_since;
+    }
+    s_active = next_active;
+
+    // A connected primary keeps receiving samples, so it can recover from publish errors
+    if (primary->stats.healthy || next_active == 0 || primary->stats.connected)
+    {
+        targets[n_targets++] = primary;
+    }
+    if (next_active != 0)
+    {
+        targets[n_targets++] = &s_endpoints[next_active];
+    }
+    for (int i = 1; i < s_endpoint_count; i++)
+    {
+        if (s_endpoints[i].role == MQTT_ROLE_MIRROR && s_endpoints[i].stats.healthy)
+        {
+            targets[n_targets++] = &s_endpoints[i];
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (previous_active != s_active)
+    {
+        if (s_active == 0)
+        {
+            ESP_LOGI(TAG, "Primary %s healthy again, failing back", s_endpoints[0].uri);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Primary unhealthy, failing over to %s", s_endpoints[s_active].uri);
+        }
+    }
+
+    int queued = 0;
+    for (int i = 0; i < n_targets; i++)
+    {
+        atomic_fetch_add(&payload->refs, 1);
+        if (xQueueSend(targets[i]->queue, &payload, 0) == pdTRUE)
+        {
+            queued++;
+            continue;
+        }
+        shared_payload_release(payload);
+        taskENTER_CRITICAL(&s_lock);
+        targets[i]->stats.queue_drops++;
+        taskEXIT_CRITICAL(&s_lock);
+        ESP_LOGW(TAG, "[%s] queue full, sample dropped", mqtt_role_name(targets[i]->role));
+    }
+    return queued > 0 ? ESP_OK : ESP_FAIL;
+}
+
+int mqtt_endpoint_count(void)
+{
+    return s_endpoint_count;
+}
+
+esp_err_t mqtt_get_endpoint_stats(int index, mqtt_role_t *role, mqtt_endpoint_stats_t *stats)
+{
+    if (index < 0 || index >= s_endpoint_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    *role = s_endpoints[index].role;
+    *stats = s_endpoints[index].stats;
+    taskEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+const char *mqtt_role_name(mqtt_role_t role)
+{
+    switch (role)
+    {
+    case MQTT_ROLE_PRIMARY:
+        return "primary";
+    case MQTT_ROLE_SECONDARY:
+        return "secondary";
+    default:
+        return "mirror";
+    }
+}
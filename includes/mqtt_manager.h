@@ -1,19 +1,166 @@
 #ifndef MQTT_MANAGER_H
 #define MQTT_MANAGER_H
 
+#include <stdatomic.h>
+#include <stdbool.h>
+
 #include "mqtt_client.h"
 #include "esp_log.h"
+#include "tls_manager.h"
+
+#define MQTT_TLS_SCHEME "mqtts://"      /**< URI prefix selecting the TLS transport with session resumption */
+#define MQTT_CLIENT_ID_PREFIX "iot_env_station_"
+#define MQTT_CLIENT_ID_LEN 40           /**< Buffer size of a client ID: prefix, MAC suffix and role suffix */
+#define MQTT_SAMPLE_TOPIC "/home/office/dht"
+
+/* Additional broker endpoints, "" disables them. CONFIG_BROKER_URI is always the primary */
+#ifndef MQTT_SECONDARY_BROKER_URI
+#define MQTT_SECONDARY_BROKER_URI ""    /**< Takes over while the primary is unhealthy */
+#endif
+#ifndef MQTT_MIRROR_BROKER_URI
+#define MQTT_MIRROR_BROKER_URI ""       /**< Receives every sample regardless of the primary state */
+#endif
+
+#define MQTT_MAX_ENDPOINTS 3            /**< Primary, secondary and mirror; also the TLS session slot of each */
+#define MQTT_ENDPOINT_QUEUE_LEN 4       /**< Samples waiting to be published per endpoint */
+#define MQTT_UNHEALTHY_ERRORS 3         /**< Consecutive publish errors that mark a connected endpoint unhealthy */
+#define MQTT_RECONNECT_MS (10 * 1000)   /**< esp-mqtt automatic reconnect delay of every endpoint */
+#define MQTT_FAILOVER_HOLDOFF_MS (15 * 1000) /**< Time the primary must stay unhealthy before the secondary takes over */
+
+/**
+ * @brief Role of a broker endpoint
+ */
+typedef enum
+{
+    MQTT_ROLE_PRIMARY,      /**< Receives the samples while it is healthy */
+    MQTT_ROLE_SECONDARY,    /**< Receives the samples while the primary is not healthy */
+    MQTT_ROLE_MIRROR,       /**< Receives every sample */
+} mqtt_role_t;
+
+/**
+ * @brief Health and failover statistics of a broker endpoint
+ */
+typedef struct
+{
+    bool connected;              /**< MQTT session currently established */
+    bool healthy;                /**< Connected and publishing without repeated errors */
+    uint32_t connects;           /**< Number of MQTT_EVENT_CONNECTED events */
+    uint32_t disconnects;        /**< Number of MQTT_EVENT_DISCONNECTED events */
+    uint32_t published;          /**< Samples accepted by the client */
+    uint32_t publish_errors;     /**< Samples the client refused */
+    uint32_t queue_drops;        /**< Samples dropped because the endpoint queue was full */
+    uint32_t failovers;          /**< Times this endpoint took over from the primary */
+    int64_t last_failover_us;    /**< Primary loss to first publish here, last takeover (0 if none measured) */
+    int64_t max_failover_us;     /**< Primary loss to first publish here, worst takeover */
+} mqtt_endpoint_stats_t;
+
+/**
+ * @brief Encoded sample shared by every endpoint it is published to
+ *
+ * The payload is serialized once and each endpoint worker holds a
+ * reference until its client has copied it into the outgoing buffer.
+ */
+typedef struct
+{
+    atomic_uint refs;   /**< Number of holders, the payload is freed when it drops to zero */
+    size_t len;         /**< Payload length in bytes */
+    char *data;         /**< Heap allocated payload, owned by this object */
+} shared_payload_t;
 
 /**
  * @fn void setup_mqtt(void)
  * @brief Initializes and configures the MQTT client for IoT communication
- * 
+ *
  * This function sets up the MQTT client with the necessary configuration
  * including broker connection details and event handlers. It establishes
  * the connection to the MQTT broker and prepares the client for publishing
  * sensor data and receiving commands. The configuration parameters are
  * typically read from the ESP-IDF configuration system (menuconfig).
+ *
+ * One client is started per configured endpoint: CONFIG_BROKER_URI as the
+ * primary, plus MQTT_SECONDARY_BROKER_URI and MQTT_MIRROR_BROKER_URI when
+ * they are set. Every client keeps its connection open, so a failover does
+ * not wait for a connect, and publishes from its own task, so a slow broker
+ * does not delay the others.
+ *
+ * Endpoints whose URI starts with "mqtts://" go through the TLS transport
+ * of tls_manager, using the endpoint index as session slot, which resumes
+ * the cached TLS session on reconnects. The clients always use a persistent
+ * MQTT session (clean_session = false) with a client ID derived from the
+ * MAC address, so subscriptions are only sent when the broker reports no
+ * stored session. The primary uses the bare ID and the other endpoints
+ * append their role ("_secondary", "_mirror"), so brokers in a cluster or
+ * behind one listener never see two clients with the same ID.
  */
 void setup_mqtt(void);
 
-#endif
\ No newline at end of file
+/**
+ * @fn shared_payload_t *shared_payload_create(char *data)
+ * @brief Wraps an encoded sample into a shared payload with one reference
+ *
+ * @param data Heap allocated, NUL terminated payload. Ownership is taken
+ *             in every case, it is freed if the wrapper cannot be allocated.
+ * @return The shared payload, or NULL if data is NULL or out of memory
+ */
+shared_payload_t *shared_payload_create(char *data);
+
+/**
+ * @fn void shared_payload_release(shared_payload_t *payload)
+ * @brief Drops one reference, freeing the payload with the last one
+ *
+ * @param payload Shared payload, NULL is ignored
+ */
+void shared_payload_release(shared_payload_t *payload);
+
+/**
+ * @fn esp_err_t mqtt_publish_shared(shared_payload_t *payload)
+ * @brief Fans a sample out to the endpoints that should receive it
+ *
+ * The sample goes to the primary while it is healthy, to the first healthy
+ * secondary once the primary has been unhealthy for MQTT_FAILOVER_HOLDOFF_MS,
+ * and to every healthy mirror. A primary that is connected but failing
+ * keeps receiving samples, so a successful publish restores it. Each
+ * selected endpoint takes its own reference; the caller keeps its reference
+ * and releases it afterwards.
+ *
+ * The hold-off is longer than MQTT_RECONNECT_MS, so a single disconnect that
+ * esp-mqtt recovers from on its own does not move the traffic. The time from
+ * the primary's last loss (disconnect or repeated publish errors) to the
+ * first publish on the secondary is logged and kept as the failover latency
+ * of the secondary. A primary that never connected since boot still fails
+ * over after the hold-off, but no latency is recorded for it.
+ *
+ * @param payload Shared payload to publish on MQTT_SAMPLE_TOPIC
+ * @return ESP_OK if at least one endpoint queued the sample, ESP_FAIL otherwise
+ */
+esp_err_t mqtt_publish_shared(shared_payload_t *payload);
+
+/**
+ * @fn int mqtt_endpoint_count(void)
+ * @brief Returns the number of configured broker endpoints
+ *
+ * @return Number of endpoints, 0 before setup_mqtt()
+ */
+int mqtt_endpoint_count(void);
+
+/**
+ * @fn esp_err_t mqtt_get_endpoint_stats(int index, mqtt_role_t *role, mqtt_endpoint_stats_t *stats)
+ * @brief Returns a snapshot of the statistics of a broker endpoint
+ *
+ * @param index Endpoint index, from 0 to mqtt_endpoint_count() - 1
+ * @param role Pointer that receives the endpoint role
+ * @param stats Pointer to the structure that receives the statistics
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown endpoint
+ */
+esp_err_t mqtt_get_endpoint_stats(int index, mqtt_role_t *role, mqtt_endpoint_stats_t *stats);
+
+/**
+ * @fn const char *mqtt_role_name(mqtt_role_t role)
+ * @brief Returns the lowercase name of an endpoint role
+ *
+ * @param role Endpoint role
+ * @return "primary", "secondary" or "mirror"
+ */
+const char *mqtt_role_name(mqtt_role_t role);
+
+#endif
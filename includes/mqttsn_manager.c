@@ -0,0 +1,226 @@
+#include "mqttsn_manager.h"
+
+#include <string.h>
+
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "MQTT-SN";
+
+static int s_sock = -1;
+static uint16_t s_msg_id = 0;
+static mqttsn_stats_t s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint16_t next_msg_id(void)
+{
+    // Message ID 0 is reserved
+    if (++s_msg_id == 0)
+    {
+        s_msg_id = 1;
+    }
+    return s_msg_id;
+}
+
+/*
+ * PUBLISH layout: Length | MsgType | Flags | TopicId(2) | MsgId(2) | Data
+ * Length is one byte up to 255, otherwise 0x01 followed by a 16-bit length.
+ * Returns the packet length and the offset of the Flags byte.
+ */
+static size_t encode_publish(uint8_t *buf, uint8_t flags, uint16_t topic_id, uint16_t msg_id,
+                             const char *payload, size_t len, size_t *flags_offset)
+{
+    size_t header = 7;
+    size_t total = header + len;
+    size_t pos = 0;
+
+    if (total > 255)
+    {
+        total += 2;
+        buf[pos++] = 0x01;
+        buf[pos++] = (uint8_t)(total >> 8);
+        buf[pos++] = (uint8_t)(total & 0xFF);
+    }
+    else
+    {
+        buf[pos++] = (uint8_t)total;
+    }
+    buf[pos++] = MQTTSN_PUBLISH;
+    *flags_offset = pos;
+    buf[pos++] = flags;
+    buf[pos++] = (uint8_t)(topic_id >> 8);
+    buf[pos++] = (uint8_t)(topic_id & 0xFF);
+    buf[pos++] = (uint8_t)(msg_id >> 8);
+    buf[pos++] = (uint8_t)(msg_id & 0xFF);
+    memcpy(&buf[pos], payload, len);
+    return pos + len;
+}
+
+static void count_bytes(uint32_t sent, uint32_t received)
+{
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.bytes_sent += sent;
+    s_stats.bytes_received += received;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+/*
+ * Waits for the PUBACK matching msg_id until the deadline. Stale PUBACKs of
+ * earlier retransmitted samples are skipped.
+ * Returns 1 when accepted, 0 on timeout and -1 when rejected or on error.
+ */
+static int wait_puback(uint16_t topic_id, uint16_t msg_id, int64_t deadline_us)
+{
+    uint8_t buf[16];
+    while (true)
+    {
+        int64_t remaining_us = deadline_us - esp_timer_get_time();
+        if (remaining_us <= 0)
+        {
+            return 0;
+        }
+        struct timeval timeout = {
+            .tv_sec = remaining_us / 1000000,
+            .tv_usec = remaining_us % 1000000,
+        };
+        setsockopt(s_sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        int len = recv(s_sock, buf, sizeof(buf), 0);
+        if (len < 0)
+        {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        count_bytes(0, len);
+
+        // PUBACK: 0x07 | 0x0D | TopicId(2) | MsgId(2) | ReturnCode
+        if (len != 7 || buf[0] != 7 || buf[1] != MQTTSN_PUBACK)
+        {
+            continue;
+        }
+        uint16_t ack_topic = (buf[2] << 8) | buf[3];
+        uint16_t ack_id = (buf[4] << 8) | buf[5];
+        if (ack_id != msg_id)
+        {
+            continue;
+        }
+        if (buf[6] != MQTTSN_RC_ACCEPTED || ack_topic != topic_id)
+        {
+            ESP_LOGE(TAG, "Publish to topic %u rejected, return code %u", topic_id, buf[6]);
+            return -1;
+        }
+        return 1;
+    }
+}
+
+esp_err_t setup_mqttsn(void)
+{
+    struct sockaddr_in gateway = {
+        .sin_family = AF_INET,
+        .sin_port = htons(MQTTSN_GATEWAY_PORT),
+    };
+    if (inet_pton(AF_INET, MQTTSN_GATEWAY_ADDR, &gateway.sin_addr) != 1)
+    {
+        ESP_LOGE(TAG, "Invalid gateway address %s", MQTTSN_GATEWAY_ADDR);
+        return ESP_FAIL;
+    }
+
+    s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (s_sock < 0)
+    {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+    // Connected UDP socket: send() goes to the gateway and only its replies are received
+    if (connect(s_sock, (struct sockaddr *)&gateway, sizeof(gateway)) != 0)
+    {
+        ESP_LOGE(TAG, "Unable to set gateway address: errno %d", errno);
+        close(s_sock);
+        s_sock = -1;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Publishing to MQTT-SN gateway %s:%d", MQTTSN_GATEWAY_ADDR, MQTTSN_GATEWAY_PORT);
+    return ESP_OK;
+}
+
+esp_err_t mqttsn_publish(uint16_t topic_id, const char *payload, size_t len, bool ack)
+{
+    static uint8_t packet[MQTTSN_MAX_PACKET];
+
+    if (s_sock < 0)
+    {
+        return ESP_FAIL;
+    }
+    if (len + 9 > sizeof(packet))
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t flags = (ack ? MQTTSN_FLAG_QOS1 : MQTTSN_FLAG_QOS_M1) | MQTTSN_TOPIC_PREDEFINED;
+    uint16_t msg_id = ack ? next_msg_id() : 0;
+    size_t flags_offset;
+    size_t packet_len = encode_publish(packet, flags, topic_id, msg_id, payload, len, &flags_offset);
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.published++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    esp_err_t err = ack ? ESP_ERR_TIMEOUT : ESP_FAIL;
+    int64_t start = esp_timer_get_time();
+    int attempts = ack ? MQTTSN_MAX_RETRIES + 1 : 1;
+    for (int attempt = 0; attempt < attempts; attempt++)
+    {
+        if (attempt > 0)
+        {
+            packet[flags_offset] |= MQTTSN_FLAG_DUP;
+            taskENTER_CRITICAL(&s_stats_lock);
+            s_stats.retransmits++;
+            taskEXIT_CRITICAL(&s_stats_lock);
+        }
+
+        if (send(s_sock, packet, packet_len, 0) < 0)
+        {
+            ESP_LOGE(TAG, "Error sending publish: errno %d", errno);
+            err = ESP_FAIL;
+            break;
+        }
+        count_bytes(packet_len, 0);
+
+        if (!ack)
+        {
+            return ESP_OK;
+        }
+
+        int res = wait_puback(topic_id, msg_id, esp_timer_get_time() + MQTTSN_ACK_TIMEOUT_MS * 1000);
+        if (res > 0)
+        {
+            int64_t rtt_us = esp_timer_get_time() - start;
+            taskENTER_CRITICAL(&s_stats_lock);
+            s_stats.acked++;
+            s_stats.last_rtt_us = rtt_us;
+            s_stats.rtt_total_us += rtt_us;
+            taskEXIT_CRITICAL(&s_stats_lock);
+            ESP_LOGI(TAG, "Sample acked, msg_id=%u, %u bytes, rtt=%lld us", msg_id, (unsigned)packet_len, rtt_us);
+            return ESP_OK;
+        }
+        if (res < 0)
+        {
+            err = ESP_FAIL;
+            break;
+        }
+        ESP_LOGW(TAG, "No PUBACK for msg_id=%u (attempt %d)", msg_id, attempt + 1);
+    }
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.failed++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    return err;
+}
+
+void mqttsn_get_stats(mqttsn_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
@@ -0,0 +1,79 @@
+#ifndef MQTTSN_MANAGER_H
+#define MQTTSN_MANAGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#define USE_MQTTSN_TRANSPORT 0              /**< 1 to publish samples over UDP to an MQTT-SN gateway instead of MQTT/TCP */
+#define MQTTSN_GATEWAY_ADDR "192.168.1.10"  /**< IPv4 address of the host running tools/mqttsn_gateway.py */
+#define MQTTSN_GATEWAY_PORT 10000           /**< UDP port of the gateway */
+#define MQTTSN_TOPIC_ID_DHT 1               /**< Pre-registered topic ID mapped to /home/office/dht by the gateway */
+#define MQTTSN_USE_ACK true                 /**< Request a PUBACK (QoS 1) for every sample */
+#define MQTTSN_ACK_TIMEOUT_MS 300           /**< Time to wait for a PUBACK before retransmitting */
+#define MQTTSN_MAX_RETRIES 2                /**< Retransmissions after the first attempt */
+#define MQTTSN_MAX_PACKET 512               /**< Largest datagram sent or received */
+
+/* MQTT-SN message types and flags used by this transport */
+#define MQTTSN_PUBLISH 0x0C
+#define MQTTSN_PUBACK 0x0D
+#define MQTTSN_FLAG_DUP 0x80
+#define MQTTSN_FLAG_QOS1 0x20
+#define MQTTSN_FLAG_QOS_M1 0x60
+#define MQTTSN_TOPIC_PREDEFINED 0x01
+#define MQTTSN_RC_ACCEPTED 0x00
+
+/**
+ * @brief Transport counters, used to compare wire cost with the MQTT/TCP path
+ */
+typedef struct
+{
+    uint32_t published;       /**< Samples handed to mqttsn_publish() */
+    uint32_t acked;           /**< Samples confirmed by the gateway */
+    uint32_t retransmits;     /**< Datagrams resent after an ACK timeout */
+    uint32_t failed;          /**< Samples given up after all retries */
+    uint32_t bytes_sent;      /**< MQTT-SN bytes sent, retransmissions included */
+    uint32_t bytes_received;  /**< MQTT-SN bytes received */
+    int64_t last_rtt_us;      /**< Round-trip time of the last acknowledged sample */
+    int64_t rtt_total_us;     /**< Accumulated round-trip time of acknowledged samples */
+} mqttsn_stats_t;
+
+/**
+ * @fn esp_err_t setup_mqttsn(void)
+ * @brief Opens the UDP socket used to reach the MQTT-SN gateway
+ *
+ * The transport is connectionless: no MQTT-SN CONNECT or REGISTER is sent.
+ * Samples are published to topic IDs that the gateway knows in advance,
+ * either with QoS -1 (fire and forget) or with a PUBACK and a small number
+ * of retransmissions.
+ *
+ * @return ESP_OK on success, ESP_FAIL if the socket could not be created
+ */
+esp_err_t setup_mqttsn(void);
+
+/**
+ * @fn esp_err_t mqttsn_publish(uint16_t topic_id, const char *payload, size_t len, bool ack)
+ * @brief Publishes a payload to a pre-registered topic ID
+ *
+ * @param topic_id Pre-registered topic ID known to the gateway
+ * @param payload Pointer to the payload bytes
+ * @param len Payload length in bytes
+ * @param ack true to wait for a PUBACK and retransmit on timeout, false for QoS -1
+ * @return ESP_OK when sent (and acknowledged if requested), ESP_ERR_TIMEOUT if no
+ *         PUBACK arrived after all retries, ESP_ERR_INVALID_SIZE if the packet is too
+ *         large, or ESP_FAIL on socket errors or a rejected publish
+ */
+esp_err_t mqttsn_publish(uint16_t topic_id, const char *payload, size_t len, bool ack);
+
+/**
+ * @fn void mqttsn_get_stats(mqttsn_stats_t *stats)
+ * @brief Copies the transport counters
+ *
+ * @param stats Pointer to the structure that receives the counters
+ */
+void mqttsn_get_stats(mqttsn_stats_t *stats);
+
+#endif
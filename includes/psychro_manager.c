@@ -0,0 +1,182 @@
+#include "psychro_manager.h"
+#include "psychro_lut.h"
+
+#define ES_T_MIN_C100 (PSYCHRO_ES_T_MIN * 100)
+#define ES_STEP_C100 (PSYCHRO_ES_T_STEP * 100)
+#define ES_T_MAX_C100 (ES_T_MIN_C100 + (PSYCHRO_ES_LEN - 1) * ES_STEP_C100)
+#define HI_T_MIN_C100 (PSYCHRO_HI_T_MIN * 100)
+#define HI_STEP_C100 (PSYCHRO_HI_T_STEP * 100)
+#define HI_T_MAX_C100 (HI_T_MIN_C100 + (PSYCHRO_HI_T_LEN - 1) * HI_STEP_C100)
+#define HI_RH_STEP_C100 (PSYCHRO_HI_RH_STEP * 100)
+
+static int32_t clamp_i32(int32_t value, int32_t min, int32_t max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+static int64_t div_round(int64_t num, int64_t den)
+{
+    // den is always positive here
+    return (num >= 0 ? num + den / 2 : num - den / 2) / den;
+}
+
+static uint32_t isqrt(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+/* Saturation vapour pressure in centi-Pa for a temperature in centi-degC */
+static uint32_t saturation_pressure(int32_t temperature)
+{
+    int32_t offset = clamp_i32(temperature, ES_T_MIN_C100, ES_T_MAX_C100) - ES_T_MIN_C100;
+    int32_t index = offset / ES_STEP_C100;
+    int32_t frac = offset % ES_STEP_C100;
+    if (index >= PSYCHRO_ES_LEN - 1)
+    {
+        index = PSYCHRO_ES_LEN - 2;
+        frac = ES_STEP_C100;
+    }
+    uint32_t low = psychro_es_lut[index];
+    uint32_t high = psychro_es_lut[index + 1];
+    return low + (uint32_t)(((uint64_t)(high - low) * frac + ES_STEP_C100 / 2) / ES_STEP_C100);
+}
+
+/* Inverse of saturation_pressure(): temperature in centi-degC for a pressure in centi-Pa */
+static int32_t saturation_temperature(uint32_t pressure)
+{
+    if (pressure <= psychro_es_lut[0])
+    {
+        return ES_T_MIN_C100;
+    }
+    if (pressure >= psychro_es_lut[PSYCHRO_ES_LEN - 1])
+    {
+        return ES_T_MAX_C100;
+    }
+
+    // Largest index whose pressure does not exceed the target
+    int32_t low = 0;
+    int32_t high = PSYCHRO_ES_LEN - 1;
+    while (high - low > 1)
+    {
+        int32_t mid = (low + high) / 2;
+        if (psychro_es_lut[mid] <= pressure)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    uint32_t span = psychro_es_lut[low + 1] - psychro_es_lut[low];
+    uint32_t delta = pressure - psychro_es_lut[low];
+    return ES_T_MIN_C100 + low * ES_STEP_C100 +
+           (int32_t)(((uint64_t)delta * ES_STEP_C100 + span / 2) / span);
+}
+
+/* Bilinear interpolation of the Rothfusz regression, result in centi-degC */
+static int32_t rothfusz(int32_t temperature, int32_t humidity)
+{
+    int32_t t_off = clamp_i32(temperature, HI_T_MIN_C100, HI_T_MAX_C100) - HI_T_MIN_C100;
+    int32_t rh_off = clamp_i32(humidity, 0, 10000);
+
+    int32_t ti = t_off / HI_STEP_C100;
+    int32_t tf = t_off % HI_STEP_C100;
+    if (ti >= PSYCHRO_HI_T_LEN - 1)
+    {
+        ti = PSYCHRO_HI_T_LEN - 2;
+        tf = HI_STEP_C100;
+    }
+    int32_t ri = rh_off / HI_RH_STEP_C100;
+    int32_t rf = rh_off % HI_RH_STEP_C100;
+    if (ri >= PSYCHRO_HI_RH_LEN - 1)
+    {
+        ri = PSYCHRO_HI_RH_LEN - 2;
+        rf = HI_RH_STEP_C100;
+    }
+
+    int64_t sum = (int64_t)psychro_hi_lut[ti][ri] * (HI_STEP_C100 - tf) * (HI_RH_STEP_C100 - rf) +
+                  (int64_t)psychro_hi_lut[ti + 1][ri] * tf * (HI_RH_STEP_C100 - rf) +
+                  (int64_t)psychro_hi_lut[ti][ri + 1] * (HI_STEP_C100 - tf) * rf +
+                  (int64_t)psychro_hi_lut[ti + 1][ri + 1] * tf * rf;
+    return (int32_t)div_round(sum, (int64_t)HI_STEP_C100 * HI_RH_STEP_C100);
+}
+
+/* NOAA heat index algorithm, all temperatures in centi-degC. *valid is false outside the table */
+static int32_t heat_index(int32_t temperature, int32_t humidity, bool *valid)
+{
+    *valid = true;
+    // Steadman's simple formula, 0.5 * (T + 61 + (T - 68) * 1.2 + RH * 0.094) in degF,
+    // scaled by 1800 to stay exact in centi-degC
+    int64_t simple_1800 = 1980LL * temperature + 47LL * humidity - 710000;
+    // Used as is while its average with the temperature stays below 80 degF,
+    // checked before rounding since the algorithm is discontinuous there
+    if (3 * simple_1800 + 5400LL * temperature < 28800000LL)
+    {
+        return (int32_t)div_round(simple_1800, 1800);
+    }
+    if (temperature < HI_T_MIN_C100 || temperature > HI_T_MAX_C100)
+    {
+        *valid = false;
+        return 0;
+    }
+
+    int32_t hi = rothfusz(temperature, humidity);
+    int32_t t_f = (int32_t)div_round(9LL * temperature, 5) + 3200;   // centi-degF
+    int32_t adjust_f = 0;                                             // centi-degF
+
+    if (humidity < 1300 && t_f >= 8000 && t_f <= 11200)
+    {
+        // - ((13 - RH) / 4) * sqrt((17 - |T - 95|) / 17)
+        int32_t distance = t_f > 9500 ? t_f - 9500 : 9500 - t_f;
+        uint32_t root_milli = isqrt((uint32_t)(1700 - distance) * 1000000U / 1700);
+        adjust_f = -(int32_t)div_round((int64_t)(1300 - humidity) * root_milli, 4000);
+    }
+    else if (humidity > 8500 && t_f >= 8000 && t_f <= 8700)
+    {
+        // + ((RH - 85) / 10) * ((87 - T) / 5)
+        adjust_f = (int32_t)div_round((int64_t)(humidity - 8500) * (8700 - t_f), 5000);
+    }
+    return hi + (int32_t)div_round(5LL * adjust_f, 9);
+}
+
+void psychro_compute(int32_t temperature, int32_t humidity, psychro_data_t *out)
+{
+    humidity = clamp_i32(humidity, 0, 10000);
+
+    uint32_t saturation = saturation_pressure(temperature);
+    uint32_t vapour = (uint32_t)(((uint64_t)saturation * humidity + 5000) / 10000);
+
+    // Absolute humidity = e / (Rv * T) with Rv = 461.5 J/(kg K), in centi-g/m3
+    int32_t kelvin = clamp_i32(temperature, ES_T_MIN_C100, ES_T_MAX_C100) + 27315;
+    uint64_t abs_humidity = ((uint64_t)vapour * 200000 + 923ULL * kelvin / 2) / (923ULL * kelvin);
+
+    bool hi_valid;
+    int32_t hi = heat_index(temperature, humidity, &hi_valid);
+
+    // Below the first table entry the dew point is colder than the table reaches
+    out->dew_point_valid = vapour >= psychro_es_lut[0];
+    out->dew_point = (int16_t)saturation_temperature(vapour);
+    out->abs_humidity = (uint16_t)(abs_humidity > UINT16_MAX ? UINT16_MAX : abs_humidity);
+    out->heat_index = (int16_t)clamp_i32(hi, INT16_MIN, INT16_MAX);
+    out->heat_index_valid = hi_valid;
+}
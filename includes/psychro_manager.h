@@ -0,0 +1,47 @@
+#ifndef PSYCHRO_MANAGER_H
+#define PSYCHRO_MANAGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PSYCHRO_METRICS_ENABLED 1   /**< 1 to add dew point, absolute humidity and heat index to the payload */
+
+/**
+ * @brief Psychrometric values derived from a temperature/humidity pair
+ *
+ * All values are fixed point with two decimals (hundredths of the unit).
+ */
+typedef struct
+{
+    int16_t dew_point;       /**< Dew point in centi-degC, only meaningful if dew_point_valid */
+    uint16_t abs_humidity;   /**< Absolute humidity in centi-g/m3 */
+    int16_t heat_index;      /**< NOAA heat index in centi-degC, only meaningful if heat_index_valid */
+    bool dew_point_valid;    /**< false when the dew point is below the saturation pressure table */
+    bool heat_index_valid;   /**< false when the temperature is above the heat index table */
+} psychro_data_t;
+
+/**
+ * @fn void psychro_compute(int32_t temperature, int32_t humidity, psychro_data_t *out)
+ * @brief Computes dew point, absolute humidity and heat index without logf/expf
+ *
+ * The saturation vapour pressure comes from a build-time generated table
+ * (see tools/gen_psychro_lut.py) with linear interpolation, the dew point
+ * from a binary search and interpolation on the same table, and the heat
+ * index from a bilinear interpolation of the Rothfusz regression plus the
+ * NOAA adjustments in integer arithmetic.
+ *
+ * Dew point and absolute humidity cover -40 to 80 degC, the full AM2301
+ * range; temperatures outside it are clamped. A dew point below -40 degC
+ * (very dry air, or 0 % RH) clears dew_point_valid. The heat index regression
+ * table covers 25 to 50 degC. Whenever the Rothfusz branch would need it
+ * outside that range, heat_index_valid is cleared rather than reporting a
+ * clamped value. Accuracy against a double-precision reference is checked
+ * on the host with tools/psychro_check.c.
+ *
+ * @param temperature Temperature in centi-degC
+ * @param humidity Relative humidity in centi-% (0 to 10000)
+ * @param out Pointer to the structure that receives the derived values
+ */
+void psychro_compute(int32_t temperature, int32_t humidity, psychro_data_t *out);
+
+#endif
@@ -0,0 +1,242 @@
+#include "sampling_manager.h"
+#include "common.h"
+
+#include <math.h>
+
+static sampling_config_t s_config = {
+    .min_interval_ms = SAMPLING_DEFAULT_MIN_MS,
+    .max_interval_ms = SAMPLING_DEFAULT_MAX_MS,
+    .temp_rate_threshold = SAMPLING_DEFAULT_TEMP_RATE,
+    .hum_rate_threshold = SAMPLING_DEFAULT_HUM_RATE,
+};
+static portMUX_TYPE s_config_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t s_interval_ms = MEASURE_INTERVAL;
+
+/**
+ * @brief Reading a rate is measured against
+ *
+ * It only moves once a new reading differs from it by more than the
+ * deadband, so a slow ramp accumulates until it becomes measurable.
+ */
+typedef struct
+{
+    float value;
+    TickType_t tick;
+} sampling_reference_t;
+
+static bool s_has_previous = false;
+static sampling_reference_t s_temp_ref;
+static sampling_reference_t s_hum_ref;
+static TimerHandle_t s_timer = NULL;
+
+static bool config_is_valid(const sampling_config_t *config)
+{
+    return config->min_interval_ms >= DHT_MIN_INTERVAL_MS &&
+           config->max_interval_ms >= config->min_interval_ms &&
+           config->temp_rate_threshold > 0 &&
+           config->hum_rate_threshold > 0;
+}
+
+/*
+ * Rate of change against the reference in centi-units per minute. Below
+ * the deadband the change is not measurable yet: the reference is kept,
+ * *moved is false and the returned rate is the largest one the deadband
+ * can still hide over the elapsed time, so a ramp is never taken for a
+ * flat signal before it crosses the deadband.
+ */
+static float reference_rate(sampling_reference_t *ref, float value, float deadband, TickType_t now, bool *moved)
+{
+    uint32_t elapsed_ms = pdTICKS_TO_MS(now - ref->tick);
+    if (elapsed_ms == 0)
+    {
+        elapsed_ms = 1;
+    }
+    float delta = fabsf(value - ref->value);
+    *moved = delta >= deadband;
+    if (*moved)
+    {
+        ref->value = value;
+        ref->tick = now;
+    }
+    else
+    {
+        delta = deadband;
+    }
+    return delta * 100.0f * 60000.0f / elapsed_ms;
+}
+
+static uint32_t clamp_interval(uint32_t interval_ms, const sampling_config_t *config)
+{
+    if (interval_ms < config->min_interval_ms)
+    {
+        return config->min_interval_ms;
+    }
+    if (interval_ms > config->max_interval_ms)
+    {
+        return config->max_interval_ms;
+    }
+    return interval_ms;
+}
+
+esp_err_t setup_sampling(void)
+{
+    const char *TAG = "Setup Sampling";
+    sampling_config_t config = s_config;
+    nvs_handle_t handle;
+
+    esp_err_t res = nvs_open(SAMPLING_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (res == ESP_OK)
+    {
+        // Each key is optional, a missing one keeps its default value
+        nvs_get_u32(handle, "min_ms", &config.min_interval_ms);
+        nvs_get_u32(handle, "max_ms", &config.max_interval_ms);
+        nvs_get_u16(handle, "temp_rate", &config.temp_rate_threshold);
+        nvs_get_u16(handle, "hum_rate", &config.hum_rate_threshold);
+        nvs_close(handle);
+    }
+    else if (res != ESP_ERR_NVS_NOT_FOUND)
+    {
+        ESP_LOGE(TAG, "Error opening NVS namespace: %s", esp_err_to_name(res));
+        return res;
+    }
+
+    if (!config_is_valid(&config))
+    {
+        ESP_LOGW(TAG, "Invalid sampling bounds stored in NVS, using defaults");
+        config = (sampling_config_t){
+            .min_interval_ms = SAMPLING_DEFAULT_MIN_MS,
+            .max_interval_ms = SAMPLING_DEFAULT_MAX_MS,
+            .temp_rate_threshold = SAMPLING_DEFAULT_TEMP_RATE,
+            .hum_rate_threshold = SAMPLING_DEFAULT_HUM_RATE,
+        };
+    }
+
+    taskENTER_CRITICAL(&s_config_lock);
+    s_config = config;
+    s_interval_ms = clamp_interval(MEASURE_INTERVAL, &config);
+    taskEXIT_CRITICAL(&s_config_lock);
+
+    ESP_LOGI(TAG, "Sampling between %lu and %lu ms, starting at %lu ms",
+             (unsigned long)config.min_interval_ms,
+             (unsigned long)config.max_interval_ms,
+             (unsigned long)s_interval_ms);
+    return ESP_OK;
+}
+
+esp_err_t sampling_set_config(const sampling_config_t *config)
+{
+    const char *TAG = "Sampling Config";
+    if (config == NULL || !config_is_valid(config))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t res = nvs_open(SAMPLING_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (res != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error opening NVS namespace: %s", esp_err_to_name(res));
+        return res;
+    }
+    res = nvs_set_u32(handle, "min_ms", config->min_interval_ms);
+    if (res == ESP_OK)
+    {
+        res = nvs_set_u32(handle, "max_ms", config->max_interval_ms);
+    }
+    if (res == ESP_OK)
+    {
+        res = nvs_set_u16(handle, "temp_rate", config->temp_rate_threshold);
+    }
+    if (res == ESP_OK)
+    {
+        res = nvs_set_u16(handle, "hum_rate", config->hum_rate_threshold);
+    }
+    if (res == ESP_OK)
+    {
+        res = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (res != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error storing sampling config: %s", esp_err_to_name(res));
+        return res;
+    }
+
+    taskENTER_CRITICAL(&s_config_lock);
+    uint32_t previous_ms = s_interval_ms;
+    s_config = *config;
+    s_interval_ms = clamp_interval(s_interval_ms, config);
+    uint32_t interval_ms = s_interval_ms;
+    taskEXIT_CRITICAL(&s_config_lock);
+
+    // Zero block time, this may run from the timer service task itself
+    if (s_timer != NULL && interval_ms != previous_ms &&
+        xTimerChangePeriod(s_timer, pdMS_TO_TICKS(interval_ms), 0) != pdPASS)
+    {
+        ESP_LOGW(TAG, "Timer period could not be updated, applied at the next sample");
+    }
+    return ESP_OK;
+}
+
+void sampling_attach_timer(TimerHandle_t timer)
+{
+    s_timer = timer;
+}
+
+void sampling_get_config(sampling_config_t *config)
+{
+    taskENTER_CRITICAL(&s_config_lock);
+    *config = s_config;
+    taskEXIT_CRITICAL(&s_config_lock);
+}
+
+uint32_t sampling_next_interval(const dht_data_t *data)
+{
+    sampling_config_t config;
+    TickType_t now = xTaskGetTickCount();
+
+    taskENTER_CRITICAL(&s_config_lock);
+    config = s_config;
+    uint32_t interval_ms = s_interval_ms;
+    taskEXIT_CRITICAL(&s_config_lock);
+
+    if (s_has_previous)
+    {
+        // Rates in centi-units per minute, same scale as the thresholds
+        bool temp_moved, hum_moved;
+        float temp_rate = reference_rate(&s_temp_ref, data->temperature, SAMPLING_TEMP_DEADBAND, now, &temp_moved);
+        float hum_rate = reference_rate(&s_hum_ref, data->humidity, SAMPLING_HUM_DEADBAND, now, &hum_moved);
+
+        if ((temp_moved && temp_rate > config.temp_rate_threshold) ||
+            (hum_moved && hum_rate > config.hum_rate_threshold))
+        {
+            interval_ms = config.min_interval_ms;
+        }
+        else if (2.0f * temp_rate < config.temp_rate_threshold && 2.0f * hum_rate < config.hum_rate_threshold)
+        {
+            interval_ms = (interval_ms > config.max_interval_ms / 2) ? config.max_interval_ms : interval_ms * 2;
+        }
+    }
+    else
+    {
+        s_has_previous = true;
+        s_temp_ref = (sampling_reference_t){.value = data->temperature, .tick = now};
+        s_hum_ref = (sampling_reference_t){.value = data->humidity, .tick = now};
+    }
+
+    interval_ms = clamp_interval(interval_ms, &config);
+    taskENTER_CRITICAL(&s_config_lock);
+    s_interval_ms = interval_ms;
+    taskEXIT_CRITICAL(&s_config_lock);
+
+    return interval_ms;
+}
+
+uint32_t sampling_current_interval(void)
+{
+    taskENTER_CRITICAL(&s_config_lock);
+    uint32_t interval_ms = s_interval_ms;
+    taskEXIT_CRITICAL(&s_config_lock);
+    return interval_ms;
+}
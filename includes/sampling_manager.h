@@ -0,0 +1,105 @@
+#ifndef SAMPLING_MANAGER_H
+#define SAMPLING_MANAGER_H
+
+#include "dht_manager.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+
+#define SAMPLING_NVS_NAMESPACE "sampling"       /**< NVS namespace holding the scheduler bounds */
+#define DHT_MIN_INTERVAL_MS (2 * 1000)          /**< Fastest sampling period supported by the DHT22/AM2301 */
+#define SAMPLING_DEFAULT_MIN_MS DHT_MIN_INTERVAL_MS
+#define SAMPLING_DEFAULT_MAX_MS (5 * 60 * 1000)
+#define SAMPLING_DEFAULT_TEMP_RATE 50           /**< Temperature change threshold in centi-degC per minute */
+#define SAMPLING_DEFAULT_HUM_RATE 200           /**< Humidity change threshold in centi-% per minute */
+#define SAMPLING_TEMP_DEADBAND 0.15f            /**< Temperature deltas below this are treated as sensor noise */
+#define SAMPLING_HUM_DEADBAND 0.5f              /**< Humidity deltas below this are treated as sensor noise */
+
+/**
+ * @brief Bounds and thresholds used by the adaptive sampling scheduler
+ *
+ * The values are loaded from NVS at boot and can be changed at runtime
+ * through sampling_set_config(), which also persists them.
+ */
+typedef struct
+{
+    uint32_t min_interval_ms;     /**< Shortest sampling period, used while readings change quickly */
+    uint32_t max_interval_ms;     /**< Longest sampling period reached when readings are flat */
+    uint16_t temp_rate_threshold; /**< Temperature rate (centi-degC/min) above which sampling speeds up */
+    uint16_t hum_rate_threshold;  /**< Humidity rate (centi-%/min) above which sampling speeds up */
+} sampling_config_t;
+
+/**
+ * @fn esp_err_t setup_sampling(void)
+ * @brief Loads the adaptive sampling configuration from NVS
+ *
+ * Missing keys fall back to the SAMPLING_DEFAULT_* values. The initial
+ * sampling period is MEASURE_INTERVAL clamped to the configured bounds.
+ * NVS must already be initialized when this function is called.
+ *
+ * @return ESP_OK on success, or the NVS error code if the stored values could not be read
+ */
+esp_err_t setup_sampling(void);
+
+/**
+ * @fn esp_err_t sampling_set_config(const sampling_config_t *config)
+ * @brief Validates, applies and persists a new sampling configuration
+ *
+ * The current period is clamped to the new bounds and, if it changes, the
+ * timer registered with sampling_attach_timer() is re-armed right away, so
+ * a lower maximum does not wait for the running period to expire. Must not
+ * be called from an ISR.
+ *
+ * @param config Pointer to the new configuration. The minimum interval must not be
+ *               shorter than DHT_MIN_INTERVAL_MS and must not exceed the maximum one.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the bounds are inconsistent,
+ *         or the NVS error code if the values could not be stored
+ */
+esp_err_t sampling_set_config(const sampling_config_t *config);
+
+/**
+ * @fn void sampling_attach_timer(TimerHandle_t timer)
+ * @brief Registers the measurement timer driven by the scheduler
+ *
+ * @param timer Periodic timer whose period sampling_set_config() updates
+ */
+void sampling_attach_timer(TimerHandle_t timer);
+
+/**
+ * @fn void sampling_get_config(sampling_config_t *config)
+ * @brief Copies the configuration currently used by the scheduler
+ *
+ * @param config Pointer to the structure that receives the configuration
+ */
+void sampling_get_config(sampling_config_t *config);
+
+/**
+ * @fn uint32_t sampling_next_interval(const dht_data_t *data)
+ * @brief Feeds a new reading to the scheduler and returns the next sampling period
+ *
+ * Each quantity keeps a reference reading that only moves once a new
+ * reading differs from it by more than its deadband, and the rate of change
+ * is measured against it over the time elapsed since it was taken. Above
+ * either threshold the period drops to the minimum; below half of both
+ * thresholds the period doubles up to the maximum; otherwise it is kept
+ * unchanged. While a change is still within the deadband its rate is taken
+ * as the deadband over the elapsed time, so the period only grows once the
+ * signal is provably slower than half the threshold.
+ *
+ * @param data Pointer to the latest successful sensor reading
+ * @return Sampling period in milliseconds to apply to the measurement timer
+ */
+uint32_t sampling_next_interval(const dht_data_t *data);
+
+/**
+ * @fn uint32_t sampling_current_interval(void)
+ * @brief Returns the sampling period currently selected by the scheduler
+ *
+ * @return Sampling period in milliseconds
+ */
+uint32_t sampling_current_interval(void);
+
+#endif
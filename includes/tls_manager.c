@@ -0,0 +1,467 @@
+#define MBEDTLS_ALLOW_PRIVATE_ACCESS
+#include "tls_manager.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+
+#include "esp_attr.h"
+#include "esp_idf_version.h"
+#include "esp_timer.h"
+#include "esp_crt_bundle.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/version.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "TLS Manager";
+
+/**
+ * @brief Serialized TLS session kept in RTC slow memory
+ *
+ * RTC_DATA_ATTR memory is zeroed on power-on and preserved across deep
+ * sleep, so a zero length means "nothing cached since the last cold boot".
+ */
+typedef struct
+{
+    uint16_t len;
+    uint8_t data[TLS_SESSION_MAX_LEN];
+} tls_session_blob_t;
+
+typedef struct
+{
+    uint8_t slot;
+    const char *ca_pem;
+    esp_tls_t *tls;
+} tls_transport_ctx_t;
+
+RTC_DATA_ATTR static tls_session_blob_t s_rtc_sessions[TLS_SESSION_SLOTS];
+static tls_handshake_stats_t s_stats[TLS_SESSION_SLOTS];
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void session_nvs_key(uint8_t slot, char *key, size_t len)
+{
+    snprintf(key, len, "sess%u", slot);
+}
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+/*
+ * esp-tls has no public way to build a client session from saved bytes, so
+ * session_load() relies on esp_tls_client_session_t wrapping a single
+ * mbedtls_ssl_session (esp-tls private_include/esp_tls_private.h, checked
+ * against ESP-IDF v5.0 to v5.3). Saving and the resumption check only use
+ * mbedtls sessions owned by this file. Review both helpers before moving
+ * to another major version.
+ */
+#if ESP_IDF_VERSION_MAJOR != 5
+#error "tls_manager.c assumes the ESP-IDF 5.x esp_tls_client_session_t layout"
+#endif
+#if MBEDTLS_VERSION_MAJOR != 3 || MBEDTLS_VERSION_MINOR < 2
+#error "tls_manager.c reads the mbedtls 3.x session master secret and needs mbedtls_ssl_get_version_number() (3.2+)"
+#endif
+
+static mbedtls_ssl_session *as_mbedtls_session(esp_tls_client_session_t *session)
+{
+    return (mbedtls_ssl_session *)session;
+}
+
+static void session_store(uint8_t slot, const mbedtls_ssl_session *session, bool persist)
+{
+    tls_session_blob_t *blob = &s_rtc_sessions[slot];
+    size_t olen = 0;
+    if (mbedtls_ssl_session_save(session, blob->data, sizeof(blob->data), &olen) != 0)
+    {
+        ESP_LOGW(TAG, "Session of slot %u does not fit in %d bytes, not cached", slot, TLS_SESSION_MAX_LEN);
+        blob->len = 0;
+        return;
+    }
+    blob->len = olen;
+
+    // Tickets may be renewed on every resumption, only full handshakes are
+    // written to flash to keep NVS wear low. RTC memory always has the latest.
+    if (!persist)
+    {
+        return;
+    }
+    nvs_handle_t handle;
+    if (nvs_open(TLS_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK)
+    {
+        char key[8];
+        session_nvs_key(slot, key, sizeof(key));
+        if (nvs_set_blob(handle, key, blob->data, blob->len) == ESP_OK)
+        {
+            nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+}
+
+static esp_tls_client_session_t *session_load(uint8_t slot)
+{
+    tls_session_blob_t *blob = &s_rtc_sessions[slot];
+    if (blob->len == 0)
+    {
+        // Cold boot: fall back to the copy persisted in NVS
+        nvs_handle_t handle;
+        if (nvs_open(TLS_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK)
+        {
+            char key[8];
+            size_t len = sizeof(blob->data);
+            session_nvs_key(slot, key, sizeof(key));
+            if (nvs_get_blob(handle, key, blob->data, &len) == ESP_OK)
+            {
+                blob->len = len;
+            }
+            nvs_close(handle);
+        }
+    }
+    if (blob->len == 0)
+    {
+        return NULL;
+    }
+
+    esp_tls_client_session_t *session = calloc(1, sizeof(mbedtls_ssl_session));
+    if (session == NULL)
+    {
+        return NULL;
+    }
+    mbedtls_ssl_session_init(as_mbedtls_session(session));
+    if (mbedtls_ssl_session_load(as_mbedtls_session(session), blob->data, blob->len) != 0)
+    {
+        ESP_LOGW(TAG, "Cached session of slot %u is not usable, discarding it", slot);
+        esp_tls_free_client_session(session);
+        tls_session_forget(slot);
+        return NULL;
+    }
+    return session;
+}
+
+/*
+ * A resumed TLS 1.2 session keeps the master secret of the session it was
+ * resumed from, while a full handshake always derives a new one. mbedtls 3.x
+ * has no public getter for either the secret or the resumption flag, so this
+ * is the only place that needs MBEDTLS_ALLOW_PRIVATE_ACCESS.
+ *
+ * TLS 1.3 sessions leave the master secret unset, so every handshake would
+ * compare equal. They are always counted as full handshakes instead.
+ */
+static bool session_was_resumed(const mbedtls_ssl_context *ssl, esp_tls_client_session_t *offered,
+                                const mbedtls_ssl_session *negotiated)
+{
+    if (offered == NULL || mbedtls_ssl_get_version_number(ssl) != MBEDTLS_SSL_VERSION_TLS1_2)
+    {
+        return false;
+    }
+    return memcmp(as_mbedtls_session(offered)->master, negotiated->master, sizeof(negotiated->master)) == 0;
+}
+
+/*
+ * Only a failed TLS handshake may be caused by the offered session. DNS,
+ * TCP and timeout errors happen while the network or the broker is down
+ * and the cached session is still the one to offer once it is back.
+ */
+static bool handshake_failed(esp_tls_t *tls)
+{
+    esp_tls_error_handle_t error = NULL;
+    int tls_code = 0;
+    int tls_flags = 0;
+    if (esp_tls_get_error_handle(tls, &error) != ESP_OK || error == NULL)
+    {
+        return false;
+    }
+    esp_err_t last = esp_tls_get_and_clear_last_error(error, &tls_code, &tls_flags);
+    ESP_LOGD(TAG, "Connect error %s, mbedtls -0x%04x, flags 0x%x", esp_err_to_name(last), tls_code, tls_flags);
+    return last == ESP_ERR_MBEDTLS_SSL_HANDSHAKE_FAILED && tls_code != 0;
+}
+#endif
+
+static void record_handshake(uint8_t slot, bool ok, bool resumed, int64_t elapsed_us)
+{
+    taskENTER_CRITICAL(&s_stats_lock);
+    tls_handshake_stats_t *stats = &s_stats[slot];
+    if (!ok)
+    {
+        stats->failed_handshakes++;
+    }
+    else if (resumed)
+    {
+        stats->resumed_handshakes++;
+        stats->resumed_total_us += elapsed_us;
+        stats->last_us = elapsed_us;
+    }
+    else
+    {
+        stats->full_handshakes++;
+        stats->full_total_us += elapsed_us;
+        stats->last_us = elapsed_us;
+    }
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+static int tls_poll(esp_tls_t *tls, int timeout_ms, bool for_read)
+{
+    int sockfd;
+    if (esp_tls_get_conn_sockfd(tls, &sockfd) != ESP_OK)
+    {
+        return -1;
+    }
+
+    fd_set fds, errfds;
+    FD_ZERO(&fds);
+    FD_ZERO(&errfds);
+    FD_SET(sockfd, &fds);
+    FD_SET(sockfd, &errfds);
+    struct timeval timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+
+    int ret = select(sockfd + 1,
+                     for_read ? &fds : NULL,
+                     for_read ? NULL : &fds,
+                     &errfds,
+                     timeout_ms >= 0 ? &timeout : NULL);
+    if (ret > 0 && FD_ISSET(sockfd, &errfds))
+    {
+        return -1;
+    }
+    return ret;
+}
+
+static int tls_transport_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    tls_transport_ctx_t *ctx = esp_transport_get_context_data(t);
+    esp_tls_cfg_t cfg = {
+        .timeout_ms = timeout_ms,
+    };
+    if (ctx->ca_pem != NULL)
+    {
+        cfg.cacert_buf = (const unsigned char *)ctx->ca_pem;
+        cfg.cacert_bytes = strlen(ctx->ca_pem) + 1;
+    }
+    else
+    {
+        cfg.crt_bundle_attach = esp_crt_bundle_attach;
+    }
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    esp_tls_client_session_t *offered = session_load(ctx->slot);
+    cfg.client_session = offered;
+#endif
+
+    ctx->tls = esp_tls_init();
+    if (ctx->tls == NULL)
+    {
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        if (offered != NULL)
+        {
+            esp_tls_free_client_session(offered);
+        }
+#endif
+        return -1;
+    }
+
+    int64_t start = esp_timer_get_time();
+    int ret = esp_tls_conn_new_sync(host, strlen(host), port, &cfg, ctx->tls);
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    if (ret <= 0)
+    {
+        ESP_LOGE(TAG, "TLS connection to %s:%d failed", host, port);
+        record_handshake(ctx->slot, false, false, elapsed_us);
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        if (offered != NULL)
+        {
+            if (handshake_failed(ctx->tls))
+            {
+                // The cached session may be the cause, retry from scratch next time
+                tls_session_forget(ctx->slot);
+            }
+            esp_tls_free_client_session(offered);
+        }
+#endif
+        esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+        return -1;
+    }
+
+    bool resumed = false;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // Copy the negotiated session straight out of the mbedtls context
+    mbedtls_ssl_context *ssl = esp_tls_get_ssl_context(ctx->tls);
+    mbedtls_ssl_session negotiated;
+    mbedtls_ssl_session_init(&negotiated);
+    if (ssl != NULL && mbedtls_ssl_get_session(ssl, &negotiated) == 0)
+    {
+        resumed = session_was_resumed(ssl, offered, &negotiated);
+        session_store(ctx->slot, &negotiated, !resumed);
+    }
+    mbedtls_ssl_session_free(&negotiated);
+    if (offered != NULL)
+    {
+        esp_tls_free_client_session(offered);
+    }
+#endif
+
+    record_handshake(ctx->slot, true, resumed, elapsed_us);
+    ESP_LOGI(TAG, "TLS handshake with %s:%d (%s) took %lld ms",
+             host, port, resumed ? "resumed" : "full", elapsed_us / 1000);
+    return 0;
+}
+
+static int tls_transport_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    tls_transport_ctx_t *ctx = esp_transport_get_context_data(t);
+    if (ctx->tls == NULL)
+    {
+        return -1;
+    }
+    if (esp_tls_get_bytes_avail(ctx->tls) > 0)
+    {
+        return 1;
+    }
+    return tls_poll(ctx->tls, timeout_ms, true);
+}
+
+static int tls_transport_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    tls_transport_ctx_t *ctx = esp_transport_get_context_data(t);
+    if (ctx->tls == NULL)
+    {
+        return -1;
+    }
+    return tls_poll(ctx->tls, timeout_ms, false);
+}
+
+static int tls_transport_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+{
+    tls_transport_ctx_t *ctx = esp_transport_get_context_data(t);
+    int poll = tls_transport_poll_read(t, timeout_ms);
+    if (poll == -1)
+    {
+        return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+    }
+    if (poll == 0)
+    {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+
+    int ret = esp_tls_conn_read(ctx->tls, (unsigned char *)buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE)
+    {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if (ret == 0)
+    {
+        // Socket was readable but nothing came out: the peer closed the connection
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    return ret;
+}
+
+static int tls_transport_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms)
+{
+    tls_transport_ctx_t *ctx = esp_transport_get_context_data(t);
+    if (tls_transport_poll_write(t, timeout_ms) <= 0)
+    {
+        ESP_LOGW(TAG, "Poll timeout or error on write, timeout=%d ms", timeout_ms);
+        return -1;
+    }
+    int ret = esp_tls_conn_write(ctx->tls, (const unsigned char *)buffer, len);
+    if (ret < 0)
+    {
+        ESP_LOGE(TAG, "esp_tls_conn_write error, errno=%s", strerror(errno));
+    }
+    return ret;
+}
+
+static int tls_transport_close(esp_transport_handle_t t)
+{
+    tls_transport_ctx_t *ctx = esp_transport_get_context_data(t);
+    int ret = 0;
+    if (ctx->tls != NULL)
+    {
+        ret = esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+    }
+    return ret;
+}
+
+static int tls_transport_destroy(esp_transport_handle_t t)
+{
+    tls_transport_ctx_t *ctx = esp_transport_get_context_data(t);
+    tls_transport_close(t);
+    free(ctx);
+    return 0;
+}
+
+esp_transport_handle_t tls_transport_create(uint8_t slot, const char *ca_pem)
+{
+    if (slot >= TLS_SESSION_SLOTS)
+    {
+        ESP_LOGE(TAG, "Invalid session slot %u", slot);
+        return NULL;
+    }
+
+    tls_transport_ctx_t *ctx = calloc(1, sizeof(tls_transport_ctx_t));
+    if (ctx == NULL)
+    {
+        return NULL;
+    }
+    ctx->slot = slot;
+    ctx->ca_pem = ca_pem;
+
+    esp_transport_handle_t t = esp_transport_init();
+    if (t == NULL)
+    {
+        free(ctx);
+        return NULL;
+    }
+    esp_transport_set_context_data(t, ctx);
+    esp_transport_set_default_port(t, TLS_DEFAULT_PORT);
+    esp_transport_set_func(t,
+                           tls_transport_connect,
+                           tls_transport_read,
+                           tls_transport_write,
+                           tls_transport_close,
+                           tls_transport_poll_read,
+                           tls_transport_poll_write,
+                           tls_transport_destroy);
+    return t;
+}
+
+void tls_session_forget(uint8_t slot)
+{
+    if (slot >= TLS_SESSION_SLOTS)
+    {
+        return;
+    }
+    s_rtc_sessions[slot].len = 0;
+
+    nvs_handle_t handle;
+    if (nvs_open(TLS_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK)
+    {
+        char key[8];
+        session_nvs_key(slot, key, sizeof(key));
+        if (nvs_erase_key(handle, key) == ESP_OK)
+        {
+            nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+}
+
+void tls_get_stats(uint8_t slot, tls_handshake_stats_t *stats)
+{
+    if (slot >= TLS_SESSION_SLOTS)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    taskENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats[slot];
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
@@ -0,0 +1,68 @@
+#ifndef TLS_MANAGER_H
+#define TLS_MANAGER_H
+
+#include "esp_transport.h"
+#include "esp_tls.h"
+#include "esp_log.h"
+
+#define TLS_NVS_NAMESPACE "tls"     /**< NVS namespace holding the persisted TLS sessions */
+#define TLS_SESSION_SLOTS 3         /**< Number of independent session caches (one per broker endpoint) */
+#define TLS_SESSION_MAX_LEN 1536    /**< Maximum size of a serialized session (peer certificate stored as a digest); all slots live in RTC memory */
+#define TLS_DEFAULT_PORT 8883       /**< Default port for mqtts:// URIs */
+
+/**
+ * @brief Handshake statistics of a TLS transport slot
+ *
+ * Durations cover the whole esp_tls connection setup (TCP connect plus TLS
+ * handshake) so that full and resumed reconnects can be compared directly.
+ */
+typedef struct
+{
+    uint32_t full_handshakes;     /**< Number of handshakes that negotiated a new session */
+    uint32_t resumed_handshakes;  /**< Number of handshakes that resumed a cached session */
+    uint32_t failed_handshakes;   /**< Number of connection attempts that failed */
+    int64_t full_total_us;        /**< Accumulated duration of full handshakes in microseconds */
+    int64_t resumed_total_us;     /**< Accumulated duration of resumed handshakes in microseconds */
+    int64_t last_us;              /**< Duration of the last successful handshake in microseconds */
+} tls_handshake_stats_t;
+
+/**
+ * @fn esp_transport_handle_t tls_transport_create(uint8_t slot, const char *ca_pem)
+ * @brief Creates an esp_transport that speaks TLS and resumes cached sessions
+ *
+ * The transport is meant to be handed to esp-mqtt through the
+ * network.transport field of its configuration. After every successful
+ * handshake the negotiated session (ID or ticket) is serialized into RTC
+ * memory, so it survives reconnects and deep sleep, and full handshakes
+ * are additionally persisted to NVS so they survive a power cycle. The next
+ * connection offers the cached session to the server; if the server
+ * refuses it a full handshake is performed transparently.
+ *
+ * Session caching requires CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS. Without it
+ * the transport still works but every connection runs a full handshake.
+ *
+ * @param slot Session cache slot, lower than TLS_SESSION_SLOTS
+ * @param ca_pem Null-terminated PEM CA certificate used to verify the broker,
+ *               or NULL to use the ESP x509 certificate bundle
+ * @return Transport handle, or NULL if it could not be allocated
+ */
+esp_transport_handle_t tls_transport_create(uint8_t slot, const char *ca_pem);
+
+/**
+ * @fn void tls_session_forget(uint8_t slot)
+ * @brief Drops the cached session of a slot from RTC memory and NVS
+ *
+ * @param slot Session cache slot, lower than TLS_SESSION_SLOTS
+ */
+void tls_session_forget(uint8_t slot);
+
+/**
+ * @fn void tls_get_stats(uint8_t slot, tls_handshake_stats_t *stats)
+ * @brief Copies the handshake statistics of a slot
+ *
+ * @param slot Session cache slot, lower than TLS_SESSION_SLOTS
+ * @param stats Pointer to the structure that receives the statistics
+ */
+void tls_get_stats(uint8_t slot, tls_handshake_stats_t *stats);
+
+#endif
@@ -13,6 +13,7 @@
  * - WiFi connection management
  */
 
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -21,6 +22,9 @@
 #include "display_manager.h"
 #include "wifi_manager.h"
 #include "mqtt_manager.h"
+#include "mqttsn_manager.h"
+#include "http_manager.h"
+#include "sampling_manager.h"
 #include "common.h"
 
 #include "freertos/task.h"
@@ -32,8 +36,7 @@
 #include "nvs_flash.h"
 
 extern EventGroupHandle_t s_wifi_event_group;  /**< WiFi event group handle */
-extern bool MQTT_CONNECTED;                    /**< MQTT connection status flag */
-extern esp_mqtt_client_handle_t client;        /**< MQTT client handle */
+extern bool MQTT_CONNECTED;                    /**< At least one MQTT broker endpoint is connected */
 
 TimerHandle_t timerDHT;     /**< Timer handle for periodic DHT sensor readings */
 QueueHandle_t displayQueue; /**< Queue for sensor data to be displayed on OLED */
@@ -49,6 +52,7 @@ void measure_temp_hum(TimerHandle_t timer);
 void task_show_data_oled(void *args);
 void task_send_data_mqtt(void *args);
 void task_wifi(void *args);
+static bool transport_connected(void);
 
 /**
  * @fn void app_main(void)
@@ -58,6 +62,7 @@ void task_wifi(void *args);
  * - Setting up NVS (Non-Volatile Storage) for configuration data
  * - Creating FreeRTOS queues for inter-task communication
  * - Initializing the DHT sensor
+ * - Loading the adaptive sampling bounds from NVS
  * - Setting up the measurement timer
  * - Creating and starting all application tasks
  * 
@@ -78,6 +83,7 @@ void app_main(void)
     displayQueue = xQueueCreate(MAX_Q_SIZE, sizeof(dht_data_t));
     mqttQueue = xQueueCreate(MAX_Q_SIZE, sizeof(dht_data_t));
     ESP_ERROR_CHECK(setup_dht());
+    ESP_ERROR_CHECK(setup_sampling());
     ESP_ERROR_CHECK(setup_timer());
     ESP_ERROR_CHECK(create_tasks());
 }
@@ -87,16 +93,17 @@ void app_main(void)
  * @brief Creates and starts the DHT sensor measurement timer
  * 
  * This function creates a FreeRTOS software timer that triggers periodic
- * temperature and humidity measurements from the DHT sensor. The timer is
- * configured to repeat at intervals defined by MEASURE_INTERVAL and calls
- * the measure_temp_hum() callback function.
+ * temperature and humidity measurements from the DHT sensor. The timer
+ * starts with the period selected by the adaptive sampling scheduler
+ * (MEASURE_INTERVAL clamped to the configured bounds) and calls the
+ * measure_temp_hum() callback function.
  * 
  * @return ESP_OK on successful timer creation and start, ESP_FAIL on error
  */
 esp_err_t setup_timer(void)
 {
     timerDHT = xTimerCreate("Timer DHT",
-                            pdMS_TO_TICKS(MEASURE_INTERVAL),
+                            pdMS_TO_TICKS(sampling_current_interval()),
                             pdTRUE,
                             (void *)TIMER_ID,
                             measure_temp_hum);
@@ -107,6 +114,7 @@ esp_err_t setup_timer(void)
     }
     else
     {
+        sampling_attach_timer(timerDHT);
         if (xTimerStart(timerDHT, 0) != pdPASS)
         {
             ESP_LOGE(TAG, "The timer could not be set into the Active state");
@@ -222,12 +230,17 @@ void task_show_data_oled(void *args)
  * This task handles MQTT communication by:
  * - Waiting for WiFi connection establishment
  * - Initializing MQTT client and SNTP time synchronization
+ * - Starting the HTTP metrics endpoint when HTTP_METRICS_ENABLED is set
  * - Continuously monitoring the MQTT queue for sensor data
  * - Converting sensor data to JSON format
  * - Publishing data to the configured MQTT topic
  * 
- * The task only attempts to send data when both the queue has data and
- * the MQTT client is connected to the broker.
+ * Each sample is encoded once and the same buffer is handed to every broker
+ * endpoint selected by mqtt_publish_shared() (primary or secondary, plus
+ * mirrors). The task only attempts to send data when both the queue has
+ * data and at least one endpoint is connected. When USE_MQTTSN_TRANSPORT is
+ * enabled the samples are instead published over UDP to the MQTT-SN gateway,
+ * which only requires the WiFi connection to be up.
  * 
  * @param args Pointer to task parameters (unused in this implementation)
  */
@@ -242,28 +255,73 @@ void task_send_data_mqtt(void *args)
     if ((bits & WIFI_CONNECTED_BIT) == 1)
     {
         ESP_LOGI(TAG, "WiFi connected, starting MQTT task and SNTP");
+#if USE_MQTTSN_TRANSPORT
+        // mqttsn_publish() fails cleanly without a socket, keep the station running
+        if (setup_mqttsn() != ESP_OK)
+        {
+            ESP_LOGE(TAG, "MQTT-SN transport could not be started");
+        }
+#else
         setup_mqtt();
+#endif
         setup_sntp();
+#if HTTP_METRICS_ENABLED
+        if (setup_http() != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Metrics endpoint could not be started");
+        }
+#endif
     }
 
     dht_data_t sensorData = {0};
     while (true)
     {
-        if ((xQueueReceive(mqttQueue, &sensorData, portMAX_DELAY)) && MQTT_CONNECTED)
+        if ((xQueueReceive(mqttQueue, &sensorData, portMAX_DELAY)) && transport_connected())
         {
             // Convert to JSON string
             char *json_str = create_json_payload(&sensorData);
-            esp_mqtt_client_publish(client, "/home/office/dht", json_str, 0, 0, 0);
+#if USE_MQTTSN_TRANSPORT
+            bool published = mqttsn_publish(MQTTSN_TOPIC_ID_DHT, json_str, strlen(json_str), MQTTSN_USE_ACK) == ESP_OK;
+            if (!published)
+            {
+                ESP_LOGE(TAG, "Error publishing data to MQTT-SN gateway");
+            }
             free(json_str);
+#else
+            // The shared payload owns json_str from here on
+            shared_payload_t *payload = shared_payload_create(json_str);
+            bool published = mqtt_publish_shared(payload) == ESP_OK;
+            shared_payload_release(payload);
+#endif
+            http_metrics_inc(published ? METRIC_PUBLISHED : METRIC_PUBLISH_ERRORS);
         }
         else
         {
             ESP_LOGE(TAG, "Error receiving data or no data in buffer");
+            http_metrics_inc(METRIC_PUBLISH_ERRORS);
         }
         vTaskDelay(pdMS_TO_TICKS(100));
     }
 }
 
+/**
+ * @fn static bool transport_connected(void)
+ * @brief Checks whether the selected publish transport can send data
+ * 
+ * The MQTT/TCP path needs a connected broker endpoint, while the connectionless
+ * MQTT-SN path only needs the WiFi link.
+ * 
+ * @return true if a sample can be published now, false otherwise
+ */
+static bool transport_connected(void)
+{
+#if USE_MQTTSN_TRANSPORT
+    return (xEventGroupGetBits(s_wifi_event_group) & WIFI_CONNECTED_BIT) != 0;
+#else
+    return MQTT_CONNECTED;
+#endif
+}
+
 /**
  * @fn void task_wifi(void *args)
  * @brief FreeRTOS task for WiFi connection management
@@ -307,13 +365,16 @@ void task_wifi(void *args)
  * - Read temperature and humidity data from the DHT sensor
  * - Capture the current timestamp in ISO8601 format
  * - Package the data into a dht_data_t structure
+ * - Derive dew point, absolute humidity and heat index from the reading
  * - Send the data to both display and MQTT queues for processing
+ * - Record the sample and counters for the HTTP metrics endpoint
+ * - Adjust the timer period according to the adaptive sampling scheduler
  * 
  * The function handles read errors by logging appropriate error messages
  * and only sends data to queues when the sensor reading is successful.
  * Queue send operations use a timeout to prevent blocking if queues are full.
  * 
- * @param timer Handle to the timer that triggered this callback (unused)
+ * @param timer Handle to the timer that triggered this callback
  */
 void measure_temp_hum(TimerHandle_t timer)
 {
@@ -323,17 +384,37 @@ void measure_temp_hum(TimerHandle_t timer)
     get_current_date_time(dhtData.timestamp);
     if (res == ESP_OK)
     {
+        // Fixed-point inputs, rounded to hundredths
+        psychro_compute((int32_t)lroundf(dhtData.temperature * 100.0f),
+                        (int32_t)lroundf(dhtData.humidity * 100.0f),
+                        &dhtData.psychro);
+        http_metrics_inc(METRIC_SAMPLES);
+        http_metrics_record_sample(&dhtData);
         if (xQueueSend(displayQueue, &dhtData, pdMS_TO_TICKS(100)) != pdPASS)
         {
             ESP_LOGE(TAG, "Error sending data to display queue");
+            http_metrics_inc(METRIC_QUEUE_DROPS);
         }
         if (xQueueSend(mqttQueue, &dhtData, pdMS_TO_TICKS(100)) != pdPASS)
         {
             ESP_LOGE(TAG, "Error sending data to MQTT queue");
+            http_metrics_inc(METRIC_QUEUE_DROPS);
+        }
+
+        uint32_t next_interval = sampling_next_interval(&dhtData);
+        if (pdMS_TO_TICKS(next_interval) != xTimerGetPeriod(timer))
+        {
+            ESP_LOGI(TAG, "Sampling period changed to %lu ms", (unsigned long)next_interval);
+            // Called from the timer service task, so the command must not block
+            if (xTimerChangePeriod(timer, pdMS_TO_TICKS(next_interval), 0) != pdPASS)
+            {
+                ESP_LOGE(TAG, "Error changing the sampling period");
+            }
         }
     }
     else
     {
         ESP_LOGE(TAG, "Error reading data");
+        http_metrics_inc(METRIC_READ_ERRORS);
     }
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Watches the station's samples on several brokers at once to observe the
+multi-broker failover from the outside.
+
+One subscriber per broker prints every sample with its arrival time. For
+the failover set (primary and secondaries, in order) it reports every
+switch of the broker receiving the samples together with the delivery gap,
+i.e. the time between the last sample on the old broker and the first one
+on the new broker. Mirrors are watched separately and are expected to
+receive every sample. Subscribers reconnect on their own, so brokers can be
+stopped and restarted with tools/multi_broker.sh while this runs.
+
+Usage:
+    python3 tools/failover_watch.py 127.0.0.1:1883 127.0.0.1:1884 --mirror 127.0.0.1:1885
+"""
+
+import argparse
+import select
+import sys
+import threading
+import time
+
+import mqtt_wire
+
+KEEPALIVE = 30
+
+
+def subscriber(label, host, port, topic, on_sample, stop):
+    while not stop.is_set():
+        sock = None
+        try:
+            sock = mqtt_wire.open_tcp(host, port)
+            sock.sendall(mqtt_wire.connect("failover_watch_%d" % port, KEEPALIVE))
+            ptype, body, _ = mqtt_wire.read_packet(sock)
+            if ptype != mqtt_wire.CONNACK or len(body) != 2 or body[1] != 0:
+                raise ConnectionError("broker refused connection")
+            sock.sendall(mqtt_wire.subscribe(topic))
+            print("%s: subscribed" % label, flush=True)
+            last_io = time.monotonic()
+            while not stop.is_set():
+                readable, _, _ = select.select([sock], [], [], 1.0)
+                if time.monotonic() - last_io > KEEPALIVE / 2:
+                    sock.sendall(mqtt_wire.pingreq())
+                    last_io = time.monotonic()
+                if not readable:
+                    continue
+                ptype, body, _ = mqtt_wire.read_packet(sock)
+                if ptype & 0xF0 == mqtt_wire.PUBLISH:
+                    _, payload = mqtt_wire.parse_publish(ptype, body)
+                    on_sample(label, payload)
+        except OSError as err:
+            print("%s: %s, retrying" % (label, err), file=sys.stderr, flush=True)
+            time.sleep(1.0)
+        finally:
+            if sock is not None:
+                sock.close()
+
+
+class Tracker:
+    def __init__(self, failover_labels):
+        self.failover_labels = failover_labels
+        self.lock = threading.Lock()
+        self.current = None
+        self.last_time = None
+        self.counts = {}
+        self.gaps = []
+
+    def on_sample(self, label, payload):
+        now = time.monotonic()
+        with self.lock:
+            self.counts[label] = self.counts.get(label, 0) + 1
+            print("%s %-22s %s" % (time.strftime("%H:%M:%S"), label, payload.decode(errors="replace")), flush=True)
+            if label not in self.failover_labels:
+                return
+            if self.current is not None and label != self.current:
+                gap = now - self.last_time
+                self.gaps.append((self.current, label, gap))
+                print("switch %s -> %s, delivery gap %.2f s" % (self.current, label, gap), flush=True)
+            self.current = label
+            self.last_time = now
+
+    def report(self):
+        print("\nsamples per broker:")
+        for label, count in sorted(self.counts.items()):
+            print("  %-22s %d" % (label, count))
+        print("switches:")
+        for old, new, gap in self.gaps:
+            print("  %s -> %s  %.2f s" % (old, new, gap))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Observe multi-broker failover of the station")
+    parser.add_argument("brokers", nargs="+", help="primary and secondaries as host:port, in order")
+    parser.add_argument("--mirror", action="append", default=[], help="mirror broker host:port")
+    parser.add_argument("--topic", default="/home/office/dht")
+    args = parser.parse_args()
+
+    labels = ["%s:%d" % mqtt_wire.parse_hostport(b, 1883) for b in args.brokers]
+    mirrors = ["%s:%d" % mqtt_wire.parse_hostport(b, 1883) for b in args.mirror]
+    tracker = Tracker(set(labels))
+    stop = threading.Event()
+    for label in labels + mirrors:
+        host, port = mqtt_wire.parse_hostport(label, 1883)
+        threading.Thread(target=subscriber, args=(label, host, port, args.topic, tracker.on_sample, stop),
+                         daemon=True).start()
+
+    try:
+        while True:
+            time.sleep(1.0)
+    except KeyboardInterrupt:
+        stop.set()
+    tracker.report()
+
+
+if __name__ == "__main__":
+    main()
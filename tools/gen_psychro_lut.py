@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Generates psychro_lut.h, the fixed-point lookup tables used by
+includes/psychro_manager.c. Run by main/CMakeLists.txt at build time.
+
+Tables:
+  psychro_es_lut   Saturation vapour pressure over water (Magnus, Sonntag
+                   1990 coefficients) in centi-Pa, one entry per degC.
+  psychro_hi_lut   Rothfusz heat index regression in centi-degC, indexed by
+                   temperature (degC) and relative humidity (%). The NOAA
+                   low/high humidity adjustments and the simple formula used
+                   below 80 degF are applied in C, they are not smooth enough
+                   to be interpolated.
+
+Usage: gen_psychro_lut.py <output header>
+"""
+
+import math
+import sys
+
+ES_T_MIN = -40
+ES_T_MAX = 80
+ES_T_STEP = 1
+
+HI_T_MIN = 25
+HI_T_MAX = 50
+HI_T_STEP = 1
+HI_RH_STEP = 5
+
+
+def saturation_pressure_pa(t_c):
+    return 611.2 * math.exp(17.62 * t_c / (243.12 + t_c))
+
+
+def rothfusz_f(t_f, rh):
+    return (-42.379 + 2.04901523 * t_f + 10.14333127 * rh
+            - 0.22475541 * t_f * rh - 0.00683783 * t_f * t_f
+            - 0.05481717 * rh * rh + 0.00122874 * t_f * t_f * rh
+            + 0.00085282 * t_f * rh * rh - 0.00000199 * t_f * t_f * rh * rh)
+
+
+def f_to_c(t_f):
+    return (t_f - 32.0) * 5.0 / 9.0
+
+
+def c_to_f(t_c):
+    return t_c * 9.0 / 5.0 + 32.0
+
+
+def format_rows(values, per_line, width):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join("%*d" % (width, v) for v in values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit("usage: %s <output header>" % sys.argv[0])
+
+    es_temps = range(ES_T_MIN, ES_T_MAX + 1, ES_T_STEP)
+    es = [round(saturation_pressure_pa(t) * 100.0) for t in es_temps]
+
+    hi_temps = list(range(HI_T_MIN, HI_T_MAX + 1, HI_T_STEP))
+    hi_rhs = list(range(0, 101, HI_RH_STEP))
+    hi_rows = []
+    for t in hi_temps:
+        hi_rows.append([round(f_to_c(rothfusz_f(c_to_f(t), rh)) * 100.0) for rh in hi_rhs])
+
+    out = []
+    out.append("/* Generated by tools/gen_psychro_lut.py, do not edit */")
+    out.append("#ifndef PSYCHRO_LUT_H")
+    out.append("#define PSYCHRO_LUT_H")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("#define PSYCHRO_ES_T_MIN %d" % ES_T_MIN)
+    out.append("#define PSYCHRO_ES_T_STEP %d" % ES_T_STEP)
+    out.append("#define PSYCHRO_ES_LEN %d" % len(es))
+    out.append("#define PSYCHRO_HI_T_MIN %d" % HI_T_MIN)
+    out.append("#define PSYCHRO_HI_T_STEP %d" % HI_T_STEP)
+    out.append("#define PSYCHRO_HI_T_LEN %d" % len(hi_temps))
+    out.append("#define PSYCHRO_HI_RH_STEP %d" % HI_RH_STEP)
+    out.append("#define PSYCHRO_HI_RH_LEN %d" % len(hi_rhs))
+    out.append("")
+    out.append("/* Saturation vapour pressure in centi-Pa, from %d to %d degC */" % (ES_T_MIN, ES_T_MAX))
+    out.append("static const uint32_t psychro_es_lut[PSYCHRO_ES_LEN] = {")
+    out.append(format_rows(es, 8, 8))
+    out.append("};")
+    out.append("")
+    out.append("/* Rothfusz heat index in centi-degC, rows %d to %d degC, columns 0 to 100 %% RH */" %
+               (HI_T_MIN, HI_T_MAX))
+    out.append("static const int32_t psychro_hi_lut[PSYCHRO_HI_T_LEN][PSYCHRO_HI_RH_LEN] = {")
+    for t, row in zip(hi_temps, hi_rows):
+        out.append("    /* %3d degC */ {%s}," % (t, ", ".join("%d" % v for v in row)))
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    out.append("")
+
+    content = "\n".join(out)
+    try:
+        with open(sys.argv[1]) as f:
+            if f.read() == content:
+                return
+    except OSError:
+        pass
+    with open(sys.argv[1], "w") as f:
+        f.write(content)
+
+
+if __name__ == "__main__":
+    main()
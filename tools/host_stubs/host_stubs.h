@@ -0,0 +1,126 @@
+/*
+ * Minimal ESP-IDF, FreeRTOS and esp-mqtt declarations for compiling the
+ * hardware independent parts of includes/ on a host. Only what the host
+ * checks in tools/ use is declared; each check defines the functions.
+ */
+#ifndef HOST_STUBS_H
+#define HOST_STUBS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* esp_err.h */
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+
+/* esp_log.h, messages are dropped */
+static inline void host_log(const char *tag, ...)
+{
+    (void)tag;
+}
+#define ESP_LOGE(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) host_log(tag, __VA_ARGS__)
+
+/* sdkconfig.h */
+#ifndef CONFIG_BROKER_URI
+#define CONFIG_BROKER_URI "mqtt://primary.local"
+#endif
+
+/* esp_mac.h, esp_timer.h */
+#define ESP_MAC_WIFI_STA 0
+esp_err_t esp_read_mac(uint8_t *mac, int type);
+int64_t esp_timer_get_time(void);
+
+/* FreeRTOS, critical sections are no-ops on the single-threaded host */
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+typedef struct
+{
+    int unused;
+} portMUX_TYPE;
+typedef struct host_queue *QueueHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define taskENTER_CRITICAL(mux) ((void)(mux))
+#define taskEXIT_CRITICAL(mux) ((void)(mux))
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define portMAX_DELAY UINT32_MAX
+QueueHandle_t xQueueCreate(uint32_t length, uint32_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack, void *args, int priority,
+                       TaskHandle_t *handle);
+
+/* esp_transport.h */
+typedef struct host_transport *esp_transport_handle_t;
+
+/* mqtt_client.h */
+typedef const char *esp_event_base_t;
+typedef struct host_mqtt_client *esp_mqtt_client_handle_t;
+#define ESP_EVENT_ANY_ID -1
+typedef enum
+{
+    MQTT_EVENT_ERROR,
+    MQTT_EVENT_CONNECTED,
+    MQTT_EVENT_DISCONNECTED,
+    MQTT_EVENT_SUBSCRIBED,
+    MQTT_EVENT_UNSUBSCRIBED,
+    MQTT_EVENT_PUBLISHED,
+    MQTT_EVENT_DATA,
+} esp_mqtt_event_id_t;
+typedef struct
+{
+    esp_mqtt_event_id_t event_id;
+    esp_mqtt_client_handle_t client;
+    int msg_id;
+    int session_present;
+    const char *topic;
+    int topic_len;
+    const char *data;
+    int data_len;
+} esp_mqtt_event_t;
+typedef esp_mqtt_event_t *esp_mqtt_event_handle_t;
+typedef void (*esp_event_handler_t)(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data);
+typedef struct
+{
+    struct
+    {
+        struct
+        {
+            const char *uri;
+        } address;
+    } broker;
+    struct
+    {
+        const char *client_id;
+    } credentials;
+    struct
+    {
+        bool disable_clean_session;
+    } session;
+    struct
+    {
+        esp_transport_handle_t transport;
+        int reconnect_timeout_ms;
+    } network;
+} esp_mqtt_client_config_t;
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config);
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, int event, esp_event_handler_t handler,
+                                         void *args);
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char *topic, int qos);
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos,
+                            int retain);
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ * Host-side check of the multi-broker routing in includes/mqtt_manager.c.
+ *
+ * Compiles mqtt_manager.c against the stubs in tools/host_stubs with a
+ * primary, a secondary and a mirror endpoint, and drives it with a fake
+ * clock, fake broker connections and the real endpoint workers. It checks
+ * that every endpoint has its own client ID, that the secondary only takes
+ * over once the primary has been unhealthy for MQTT_FAILOVER_HOLDOFF_MS,
+ * that an outage esp-mqtt recovers from within the hold-off does not move
+ * the traffic, the failover latency measured from the primary loss and the
+ * failback. Built with -fsanitize=address, it also reports any shared
+ * payload that is never freed. Exits with a non-zero status when an
+ * expectation fails.
+ *
+ * Build and run from the repository root:
+ *   cc -std=gnu17 -Wall -fsanitize=address -Itools/host_stubs -Iincludes tools/mqtt_failover_check.c -o /tmp/mqtt_failover_check
+ *   /tmp/mqtt_failover_check
+ */
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_stubs.h"
+
+#define MQTT_SECONDARY_BROKER_URI "mqtt://secondary.local"
+#define MQTT_MIRROR_BROKER_URI "mqtt://mirror.local"
+#include "mqtt_manager.c"
+
+#define SECOND_US 1000000LL
+
+typedef struct
+{
+    char uri[64];
+    char client_id[MQTT_CLIENT_ID_LEN];
+    bool connected;
+    esp_event_handler_t handler;
+    void *handler_args;
+    int published;
+} fake_client_t;
+
+struct host_queue
+{
+    uint8_t items[MQTT_ENDPOINT_QUEUE_LEN][sizeof(void *)];
+    uint32_t item_size;
+    uint32_t head;
+    uint32_t count;
+};
+
+static int64_t s_now_us;
+static fake_client_t s_clients[MQTT_MAX_ENDPOINTS];
+static int s_client_count;
+static TaskFunction_t s_tasks[MQTT_MAX_ENDPOINTS];
+static void *s_task_args[MQTT_MAX_ENDPOINTS];
+static int s_task_count;
+static jmp_buf s_worker_idle;
+static int s_failures;
+
+#define EXPECT(cond)                                                   \
+    do                                                                 \
+    {                                                                  \
+        if (!(cond))                                                   \
+        {                                                              \
+            printf("%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+            s_failures++;                                              \
+        }                                                              \
+    } while (0)
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+esp_err_t esp_read_mac(uint8_t *mac, int type)
+{
+    static const uint8_t fake[6] = {0x24, 0x6f, 0x28, 0xa1, 0xb2, 0xc3};
+    (void)type;
+    memcpy(mac, fake, sizeof(fake));
+    return ESP_OK;
+}
+
+QueueHandle_t xQueueCreate(uint32_t length, uint32_t item_size)
+{
+    if (length > MQTT_ENDPOINT_QUEUE_LEN || item_size > sizeof(void *))
+    {
+        return NULL;
+    }
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+    queue->item_size = item_size;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    (void)wait;
+    if (queue->count == MQTT_ENDPOINT_QUEUE_LEN)
+    {
+        return pdFALSE;
+    }
+    memcpy(queue->items[(queue->head + queue->count) % MQTT_ENDPOINT_QUEUE_LEN], item, queue->item_size);
+    queue->count++;
+    return pdTRUE;
+}
+
+/* An endpoint worker that runs out of samples would block, return to run_workers() instead */
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    (void)wait;
+    if (queue->count == 0)
+    {
+        longjmp(s_worker_idle, 1);
+    }
+    memcpy(item, queue->items[queue->head], queue->item_size);
+    queue->head = (queue->head + 1) % MQTT_ENDPOINT_QUEUE_LEN;
+    queue->count--;
+    return pdTRUE;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack, void *args, int priority,
+                       TaskHandle_t *handle)
+{
+    (void)name, (void)stack, (void)priority, (void)handle;
+    if (s_task_count == MQTT_MAX_ENDPOINTS)
+    {
+        return pdFALSE;
+    }
+    s_tasks[s_task_count] = task;
+    s_task_args[s_task_count] = args;
+    s_task_count++;
+    return pdPASS;
+}
+
+esp_transport_handle_t tls_transport_create(uint8_t slot, const char *ca_pem)
+{
+    (void)slot, (void)ca_pem;
+    return NULL;
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config)
+{
+    if (s_client_count == MQTT_MAX_ENDPOINTS)
+    {
+        return NULL;
+    }
+    // esp-mqtt copies the strings of the configuration
+    fake_client_t *client = &s_clients[s_client_count++];
+    snprintf(client->uri, sizeof(client->uri), "%s", config->broker.address.uri);
+    snprintf(client->client_id, sizeof(client->client_id), "%s", config->credentials.client_id);
+    return (esp_mqtt_client_handle_t)client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t handle, int event, esp_event_handler_t handler,
+                                         void *args)
+{
+    (void)event;
+    fake_client_t *client = (fake_client_t *)handle;
+    client->handler = handler;
+    client->handler_args = args;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t handle, const char *topic, int qos)
+{
+    (void)handle, (void)topic, (void)qos;
+    return 1;
+}
+
+/* QoS 0 publishes fail while the client is disconnected */
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t handle, const char *topic, const char *data, int len, int qos,
+                            int retain)
+{
+    (void)topic, (void)data, (void)len, (void)qos, (void)retain;
+    fake_client_t *client = (fake_client_t *)handle;
+    if (!client->connected)
+    {
+        return -1;
+    }
+    return ++client->published;
+}
+
+static void set_connected(int index, bool connected)
+{
+    fake_client_t *client = &s_clients[index];
+    esp_mqtt_event_t event = {
+        .event_id = connected ? MQTT_EVENT_CONNECTED : MQTT_EVENT_DISCONNECTED,
+        .client = (esp_mqtt_client_handle_t)client,
+    };
+    client->connected = connected;
+    client->handler(client->handler_args, "MQTT_EVENTS", event.event_id, &event);
+}
+
+static void at(int64_t seconds)
+{
+    s_now_us = seconds * SECOND_US;
+}
+
+/* Lets every endpoint worker publish what is queued for it */
+static void run_workers(void)
+{
+    for (int i = 0; i < s_task_count; i++)
+    {
+        if (setjmp(s_worker_idle) == 0)
+        {
+            s_tasks[i](s_task_args[i]);
+        }
+    }
+}
+
+/* One sample as main.c sends it, at the given time in seconds since boot */
+static void send_sample(int64_t seconds)
+{
+    at(seconds);
+    shared_payload_t *payload = shared_payload_create(strdup("{\"temperature\":\"23.50\"}"));
+    EXPECT(mqtt_publish_shared(payload) == ESP_OK);
+    shared_payload_release(payload);
+    run_workers();
+}
+
+int main(void)
+{
+    fake_client_t *primary = &s_clients[0];
+    fake_client_t *secondary = &s_clients[1];
+    fake_client_t *mirror = &s_clients[2];
+
+    setup_mqtt();
+    EXPECT(mqtt_endpoint_count() == 3);
+    EXPECT(strcmp(primary->client_id, "iot_env_station_a1b2c3") == 0);
+    EXPECT(strcmp(secondary->client_id, "iot_env_station_a1b2c3_secondary") == 0);
+    EXPECT(strcmp(mirror->client_id, "iot_env_station_a1b2c3_mirror") == 0);
+
+    // Boot without the primary: the secondary takes over after the hold-off, untimed
+    at(1);
+    set_connected(1, true);
+    set_connected(2, true);
+    send_sample(2);
+    EXPECT(secondary->published == 0 && mirror->published == 1);
+    send_sample(16);
+    EXPECT(secondary->published == 1);
+    EXPECT(s_endpoints[1].stats.failovers == 1 && s_endpoints[1].stats.last_failover_us == 0);
+
+    // Failback as soon as the primary is connected
+    at(17);
+    set_connected(0, true);
+    send_sample(18);
+    EXPECT(primary->published == 1 && secondary->published == 1);
+
+    // An outage shorter than the hold-off stays on the primary
+    at(20);
+    set_connected(0, false);
+    send_sample(25);
+    EXPECT(secondary->published == 1);
+    at(30);
+    set_connected(0, true);
+    send_sample(31);
+    EXPECT(primary->published == 2 && secondary->published == 1);
+    EXPECT(s_endpoints[1].stats.failovers == 1);
+
+    // A long outage fails over, timed from the disconnect
+    at(40);
+    set_connected(0, false);
+    send_sample(50);
+    EXPECT(secondary->published == 1);
+    send_sample(56);
+    EXPECT(secondary->published == 2);
+    EXPECT(s_endpoints[1].stats.failovers == 2);
+    EXPECT(s_endpoints[1].stats.last_failover_us == 16 * SECOND_US);
+    EXPECT(s_endpoints[1].stats.max_failover_us == 16 * SECOND_US);
+
+    // The mirror got every sample while connected
+    EXPECT(mirror->published == 7);
+
+    printf("published: primary %d, secondary %d, mirror %d\n", primary->published, secondary->published,
+           mirror->published);
+    printf("%s\n", s_failures == 0 ? "ok" : "FAIL");
+    return s_failures != 0;
+}
@@ -0,0 +1,159 @@
+"""
+Minimal MQTT 3.1.1 and MQTT-SN packet helpers shared by the host tools.
+
+Only the packets exchanged by the station are covered (CONNECT/CONNACK,
+PUBLISH/PUBACK, SUBSCRIBE/SUBACK, DISCONNECT and the MQTT-SN PUBLISH/PUBACK
+subset), so the gateway and the benchmark run without third-party packages
+and can count the exact number of bytes put on the wire.
+"""
+
+import socket
+import struct
+
+# MQTT 3.1.1 packet types
+CONNECT = 0x10
+CONNACK = 0x20
+PUBLISH = 0x30
+PUBACK = 0x40
+SUBSCRIBE = 0x82
+SUBACK = 0x90
+PINGREQ = 0xC0
+DISCONNECT = 0xE0
+
+# MQTT-SN, keep in sync with includes/mqttsn_manager.h
+SN_PUBLISH = 0x0C
+SN_PUBACK = 0x0D
+SN_FLAG_DUP = 0x80
+SN_QOS_MASK = 0x60
+SN_QOS1 = 0x20
+SN_QOS_M1 = 0x60
+SN_TOPIC_TYPE_MASK = 0x03
+SN_TOPIC_PREDEFINED = 0x01
+SN_RC_ACCEPTED = 0x00
+SN_RC_INVALID_TOPIC = 0x02
+SN_RC_CONGESTION = 0x01
+
+
+def _remaining_length(n):
+    out = bytearray()
+    while True:
+        byte = n % 128
+        n //= 128
+        if n:
+            byte |= 0x80
+        out.append(byte)
+        if not n:
+            return bytes(out)
+
+
+def _string(s):
+    data = s.encode()
+    return struct.pack("!H", len(data)) + data
+
+
+def connect(client_id, keepalive=60, clean_session=True):
+    flags = 0x02 if clean_session else 0x00
+    body = _string("MQTT") + bytes([4, flags]) + struct.pack("!H", keepalive) + _string(client_id)
+    return bytes([CONNECT]) + _remaining_length(len(body)) + body
+
+
+def publish(topic, payload, qos=0, msg_id=0):
+    body = _string(topic)
+    if qos:
+        body += struct.pack("!H", msg_id)
+    body += payload
+    return bytes([PUBLISH | (qos << 1)]) + _remaining_length(len(body)) + body
+
+
+def puback(msg_id):
+    return bytes([PUBACK, 2]) + struct.pack("!H", msg_id)
+
+
+def subscribe(topic, msg_id=1, qos=0):
+    body = struct.pack("!H", msg_id) + _string(topic) + bytes([qos])
+    return bytes([SUBSCRIBE]) + _remaining_length(len(body)) + body
+
+
+def parse_publish(first_byte, body):
+    """Returns (topic, payload) of a PUBLISH packet body."""
+    length = struct.unpack("!H", body[:2])[0]
+    topic = body[2:2 + length].decode()
+    start = 2 + length + (2 if first_byte & 0x06 else 0)
+    return topic, body[start:]
+
+
+def pingreq():
+    return bytes([PINGREQ, 0])
+
+
+def disconnect():
+    return bytes([DISCONNECT, 0])
+
+
+def read_packet(sock):
+    """Reads one MQTT packet, returns (first_byte, body, total_wire_length)."""
+    header = _recv_exact(sock, 1)
+    multiplier, length, used = 1, 0, 1
+    while True:
+        byte = _recv_exact(sock, 1)[0]
+        used += 1
+        length += (byte & 0x7F) * multiplier
+        if not byte & 0x80:
+            break
+        multiplier *= 128
+    body = _recv_exact(sock, length) if length else b""
+    return header[0], body, used + length
+
+
+def _recv_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed by peer")
+        data += chunk
+    return data
+
+
+def sn_publish(topic_id, payload, msg_id=0, qos1=True, dup=False):
+    flags = (SN_QOS1 if qos1 else SN_QOS_M1) | SN_TOPIC_PREDEFINED
+    if dup:
+        flags |= SN_FLAG_DUP
+    body = bytes([SN_PUBLISH, flags]) + struct.pack("!HH", topic_id, msg_id) + payload
+    if len(body) + 1 <= 255:
+        return bytes([len(body) + 1]) + body
+    return b"\x01" + struct.pack("!H", len(body) + 3) + body
+
+
+def sn_puback(topic_id, msg_id, rc=SN_RC_ACCEPTED):
+    return bytes([7, SN_PUBACK]) + struct.pack("!HHB", topic_id, msg_id, rc)
+
+
+def sn_parse(datagram):
+    """Returns (msg_type, body) of an MQTT-SN datagram, or None if malformed."""
+    if len(datagram) < 2:
+        return None
+    if datagram[0] == 0x01:
+        if len(datagram) < 4:
+            return None
+        length = struct.unpack("!H", datagram[1:3])[0]
+        start = 3
+    else:
+        length = datagram[0]
+        start = 1
+    if length != len(datagram):
+        return None
+    return datagram[start], datagram[start + 1:]
+
+
+def parse_hostport(value, default_port):
+    host, _, port = value.rpartition(":")
+    if not host:
+        return value, default_port
+    return host, int(port)
+
+
+def open_tcp(host, port, timeout=5.0):
+    sock = socket.create_connection((host, port), timeout=timeout)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    return sock
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Host-side gateway bridging the station's MQTT-SN style UDP transport to a
+regular MQTT broker.
+
+Stations publish to pre-registered topic IDs (see MQTTSN_TOPIC_ID_DHT in
+includes/mqttsn_manager.h) without CONNECT or REGISTER. The gateway keeps a
+single persistent MQTT connection to the broker, maps each topic ID to its
+topic name, forwards the payload and answers QoS 1 publishes with a PUBACK.
+Retransmissions (DUP flag) of an already forwarded message are acknowledged
+again but not forwarded twice.
+
+Usage:
+    python3 tools/mqttsn_gateway.py --broker 127.0.0.1:1883 \\
+        --listen 0.0.0.0:10000 --topic 1=/home/office/dht
+"""
+
+import argparse
+import collections
+import socket
+import struct
+import sys
+import time
+
+import mqtt_wire
+
+
+class Broker:
+    """Persistent MQTT connection, reopened on demand."""
+
+    def __init__(self, host, port, client_id, keepalive=60):
+        self.host, self.port = host, port
+        self.client_id = client_id
+        self.keepalive = keepalive
+        self.sock = None
+        self.last_io = 0.0
+
+    def _connect(self):
+        sock = mqtt_wire.open_tcp(self.host, self.port)
+        sock.sendall(mqtt_wire.connect(self.client_id, self.keepalive))
+        ptype, body, _ = mqtt_wire.read_packet(sock)
+        if ptype != mqtt_wire.CONNACK or len(body) != 2 or body[1] != 0:
+            sock.close()
+            raise ConnectionError("broker refused connection")
+        self.sock = sock
+        self.last_io = time.monotonic()
+        print("connected to broker %s:%d" % (self.host, self.port), flush=True)
+
+    def publish(self, topic, payload):
+        for _ in range(2):
+            try:
+                if self.sock is None:
+                    self._connect()
+                self.sock.sendall(mqtt_wire.publish(topic, payload))
+                self.last_io = time.monotonic()
+                return True
+            except OSError as err:
+                print("broker error: %s" % err, file=sys.stderr, flush=True)
+                self.close()
+        return False
+
+    def keep_alive(self):
+        if self.sock is None:
+            return
+        try:
+            # Discard PINGRESPs so the receive buffer never fills up
+            self.sock.setblocking(False)
+            try:
+                while True:
+                    if not self.sock.recv(256):
+                        raise ConnectionError("connection closed by broker")
+            except BlockingIOError:
+                pass
+            finally:
+                self.sock.setblocking(True)
+            if time.monotonic() - self.last_io > self.keepalive / 2:
+                self.sock.sendall(mqtt_wire.pingreq())
+                self.last_io = time.monotonic()
+        except OSError:
+            self.close()
+
+    def close(self):
+        if self.sock is not None:
+            self.sock.close()
+            self.sock = None
+
+
+def parse_topics(values):
+    topics = {}
+    for value in values:
+        topic_id, _, name = value.partition("=")
+        if not name:
+            raise SystemExit("invalid --topic %r, expected ID=NAME" % value)
+        topics[int(topic_id)] = name
+    return topics
+
+
+def main():
+    parser = argparse.ArgumentParser(description="MQTT-SN style UDP to MQTT gateway")
+    parser.add_argument("--listen", default="0.0.0.0:10000", help="UDP address to listen on")
+    parser.add_argument("--broker", default="127.0.0.1:1883", help="MQTT broker host:port")
+    parser.add_argument("--client-id", default="iot_env_station_gateway")
+    parser.add_argument("--topic", action="append", default=[],
+                        help="pre-registered topic, ID=NAME (repeatable)")
+    args = parser.parse_args()
+
+    topics = parse_topics(args.topic or ["1=/home/office/dht"])
+    broker = Broker(*mqtt_wire.parse_hostport(args.broker, 1883), client_id=args.client_id)
+
+    udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    udp.bind(mqtt_wire.parse_hostport(args.listen, 10000))
+    udp.settimeout(1.0)
+    print("listening on %s, topics %s" % (args.listen, topics), flush=True)
+
+    # Recently forwarded (station, msg_id) pairs, used to drop duplicates
+    recent = collections.OrderedDict()
+
+    while True:
+        broker.keep_alive()
+        try:
+            datagram, addr = udp.recvfrom(2048)
+        except socket.timeout:
+            continue
+
+        parsed = mqtt_wire.sn_parse(datagram)
+        if parsed is None or parsed[0] != mqtt_wire.SN_PUBLISH or len(parsed[1]) < 5:
+            continue
+        body = parsed[1]
+        flags = body[0]
+        topic_id, msg_id = struct.unpack("!HH", body[1:5])
+        payload = body[5:]
+        wants_ack = (flags & mqtt_wire.SN_QOS_MASK) == mqtt_wire.SN_QOS1
+
+        topic = topics.get(topic_id)
+        if (flags & mqtt_wire.SN_TOPIC_TYPE_MASK) != mqtt_wire.SN_TOPIC_PREDEFINED or topic is None:
+            rc = mqtt_wire.SN_RC_INVALID_TOPIC
+        elif wants_ack and flags & mqtt_wire.SN_FLAG_DUP and (addr, msg_id) in recent:
+            rc = mqtt_wire.SN_RC_ACCEPTED
+        elif broker.publish(topic, payload):
+            rc = mqtt_wire.SN_RC_ACCEPTED
+            if wants_ack:
+                recent[(addr, msg_id)] = True
+                while len(recent) > 256:
+                    recent.popitem(last=False)
+        else:
+            rc = mqtt_wire.SN_RC_CONGESTION
+
+        if wants_ack:
+            udp.sendto(mqtt_wire.sn_puback(topic_id, msg_id, rc), addr)
+
+
+if __name__ == "__main__":
+    main()
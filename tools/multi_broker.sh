@@ -0,0 +1,69 @@
+#!/bin/sh
+# Runs several local Mosquitto instances to exercise the multi-broker
+# failover and mirror fan-out of mqtt_manager.
+#
+#   tools/multi_broker.sh up 1883 1884 1885   # start one broker per port
+#   tools/multi_broker.sh down 1883           # stop one (simulates a primary loss)
+#   tools/multi_broker.sh up 1883             # bring it back (failback)
+#   tools/multi_broker.sh down                # stop them all
+#
+# Point CONFIG_BROKER_URI, MQTT_SECONDARY_BROKER_URI and MQTT_MIRROR_BROKER_URI
+# to mqtt://<host-ip>:1883, :1884 and :1885, and watch the deliveries with
+# tools/failover_watch.py. Logs and pid files live in $MULTI_BROKER_DIR.
+set -eu
+
+DIR="${MULTI_BROKER_DIR:-/tmp/multi_broker}"
+DEFAULT_PORTS="1883 1884 1885"
+
+usage() {
+    echo "usage: $0 up|down|status [port...]" >&2
+    exit 1
+}
+
+running() {
+    [ -f "$DIR/$1.pid" ] && kill -0 "$(cat "$DIR/$1.pid")" 2>/dev/null
+}
+
+up() {
+    if running "$1"; then
+        echo "broker $1 already running"
+        return
+    fi
+    cat > "$DIR/$1.conf" <<EOF
+listener $1
+allow_anonymous true
+pid_file $DIR/$1.pid
+log_dest file $DIR/$1.log
+log_type all
+persistence true
+persistence_location $DIR/$1.db/
+EOF
+    mkdir -p "$DIR/$1.db"
+    mosquitto -c "$DIR/$1.conf" -d
+    sleep 0.2
+    running "$1" && echo "broker $1 up" || { echo "broker $1 failed, see $DIR/$1.log" >&2; exit 1; }
+}
+
+down() {
+    if running "$1"; then
+        kill "$(cat "$DIR/$1.pid")"
+        echo "broker $1 down"
+    fi
+    rm -f "$DIR/$1.pid"
+}
+
+[ $# -ge 1 ] || usage
+cmd=$1
+shift
+ports=${*:-$DEFAULT_PORTS}
+mkdir -p "$DIR"
+
+case $cmd in
+up) for p in $ports; do up "$p"; done ;;
+down)
+    [ $# -ge 1 ] || ports=$(ls "$DIR" | sed -n 's/\.pid$//p')
+    for p in $ports; do down "$p"; done
+    ;;
+status) for p in $ports; do running "$p" && echo "$p up" || echo "$p down"; done ;;
+*) usage ;;
+esac
@@ -0,0 +1,160 @@
+/*
+ * Host-side accuracy check of includes/psychro_manager.c.
+ *
+ * Sweeps temperature and humidity over the sensor range, runs the
+ * fixed-point lookup-table implementation and compares it against a
+ * double-precision reference of the same formulas (Magnus saturation
+ * pressure, closed-form dew point, ideal-gas absolute humidity and the
+ * NOAA heat index algorithm). Exits with a non-zero status when an error
+ * bound is exceeded or a validity flag disagrees with the table range.
+ *
+ * Build and run from the repository root:
+ *   python3 tools/gen_psychro_lut.py /tmp/psychro_lut.h
+ *   cc -O2 -I/tmp -Iincludes tools/psychro_check.c includes/psychro_manager.c -lm -o /tmp/psychro_check
+ *   /tmp/psychro_check
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "psychro_manager.h"
+
+#define DEW_POINT_BOUND 0.05    /* degC */
+#define ABS_HUMIDITY_BOUND 0.1  /* g/m3 */
+#define HEAT_INDEX_BOUND 0.15   /* degC */
+#define HEAT_INDEX_T_MAX 50.0   /* Upper end of the heat index table, heat_index_valid must be clear above it */
+#define DEW_POINT_MIN -40.0     /* Lower end of the saturation table, dew_point_valid must be clear below it */
+
+typedef struct
+{
+    const char *name;
+    double bound;
+    double max_error;
+    double sum_sq;
+    long count;
+    double worst_t;
+    double worst_rh;
+} error_stats_t;
+
+static double saturation_pressure(double t)
+{
+    return 611.2 * exp(17.62 * t / (243.12 + t));
+}
+
+static double dew_point(double t, double rh)
+{
+    if (rh <= 0.0)
+    {
+        return -INFINITY;
+    }
+    double gamma = log(rh / 100.0) + 17.62 * t / (243.12 + t);
+    return 243.12 * gamma / (17.62 - gamma);
+}
+
+static double abs_humidity(double t, double rh)
+{
+    return saturation_pressure(t) * rh / 100.0 / (461.5 * (t + 273.15)) * 1000.0;
+}
+
+static double heat_index(double t_c, double rh)
+{
+    double t = t_c * 9.0 / 5.0 + 32.0;
+    double hi = 0.5 * (t + 61.0 + (t - 68.0) * 1.2 + rh * 0.094);
+    if ((hi + t) / 2.0 >= 80.0)
+    {
+        hi = -42.379 + 2.04901523 * t + 10.14333127 * rh - 0.22475541 * t * rh -
+             0.00683783 * t * t - 0.05481717 * rh * rh + 0.00122874 * t * t * rh +
+             0.00085282 * t * rh * rh - 0.00000199 * t * t * rh * rh;
+        if (rh < 13.0 && t >= 80.0 && t <= 112.0)
+        {
+            hi -= ((13.0 - rh) / 4.0) * sqrt((17.0 - fabs(t - 95.0)) / 17.0);
+        }
+        else if (rh > 85.0 && t >= 80.0 && t <= 87.0)
+        {
+            hi += ((rh - 85.0) / 10.0) * ((87.0 - t) / 5.0);
+        }
+    }
+    return (hi - 32.0) * 5.0 / 9.0;
+}
+
+static void record(error_stats_t *stats, double error, double t, double rh)
+{
+    error = fabs(error);
+    stats->sum_sq += error * error;
+    stats->count++;
+    if (error > stats->max_error)
+    {
+        stats->max_error = error;
+        stats->worst_t = t;
+        stats->worst_rh = rh;
+    }
+}
+
+int main(void)
+{
+    error_stats_t stats[] = {
+        {.name = "dew point (degC)", .bound = DEW_POINT_BOUND},
+        {.name = "abs humidity (g/m3)", .bound = ABS_HUMIDITY_BOUND},
+        {.name = "heat index (degC)", .bound = HEAT_INDEX_BOUND},
+    };
+    const int n_stats = sizeof(stats) / sizeof(stats[0]);
+    long wrongly_valid = 0;
+    long wrongly_invalid = 0;
+    long dew_wrongly_valid = 0;
+    long dew_wrongly_invalid = 0;
+
+    for (int t100 = -4000; t100 <= 8000; t100 += 10)
+    {
+        for (int rh100 = 0; rh100 <= 10000; rh100 += 50)
+        {
+            double t = t100 / 100.0;
+            double rh = rh100 / 100.0;
+            psychro_data_t out;
+            psychro_compute(t100, rh100, &out);
+
+            double dp = dew_point(t, rh);
+            if (out.dew_point_valid)
+            {
+                // Within the error bound of the table end either answer is acceptable
+                if (dp < DEW_POINT_MIN - DEW_POINT_BOUND)
+                {
+                    dew_wrongly_valid++;
+                }
+                record(&stats[0], out.dew_point / 100.0 - dp, t, rh);
+            }
+            else if (dp >= DEW_POINT_MIN + DEW_POINT_BOUND)
+            {
+                dew_wrongly_invalid++;
+            }
+            record(&stats[1], out.abs_humidity / 100.0 - abs_humidity(t, rh), t, rh);
+            if (out.heat_index_valid)
+            {
+                // Above the table only the simple formula may still be reported
+                if (t > HEAT_INDEX_T_MAX)
+                {
+                    wrongly_valid++;
+                }
+                record(&stats[2], out.heat_index / 100.0 - heat_index(t, rh), t, rh);
+            }
+            else if (t <= HEAT_INDEX_T_MAX)
+            {
+                wrongly_invalid++;
+            }
+        }
+    }
+
+    int failed = 0;
+    printf("%-22s %10s %10s %10s %8s  %s\n", "quantity", "max err", "rms err", "bound", "points", "worst at");
+    for (int i = 0; i < n_stats; i++)
+    {
+        error_stats_t *s = &stats[i];
+        double rms = sqrt(s->sum_sq / s->count);
+        int ok = s->max_error <= s->bound;
+        failed |= !ok;
+        printf("%-22s %10.4f %10.4f %10.4f %8ld  T=%.2f RH=%.2f %s\n",
+               s->name, s->max_error, rms, s->bound, s->count, s->worst_t, s->worst_rh, ok ? "" : "FAIL");
+    }
+    printf("dew point validity: %ld wrongly valid, %ld wrongly invalid\n", dew_wrongly_valid, dew_wrongly_invalid);
+    printf("heat index validity: %ld wrongly valid, %ld wrongly invalid\n", wrongly_valid, wrongly_invalid);
+    return failed || dew_wrongly_valid || dew_wrongly_invalid || wrongly_valid || wrongly_invalid;
+}
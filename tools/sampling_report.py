@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+Sample-count vs reconstruction-error report for the adaptive sampling scheduler.
+
+Replays a densely recorded trace through a model of the scheduler implemented
+in includes/sampling_manager.c and through fixed-period sampling, rebuilds the
+signal by linear interpolation between the taken samples and compares it with
+the full trace.
+
+The trace is a CSV file with a header containing `timestamp`, `temperature`
+and `humidity` columns. Timestamps may be epoch seconds or ISO 8601 strings as
+published by the station ("YYYY-MM-DDTHH:MM:SSZ"). Record it with the station
+pinned to a short period (e.g. min_ms = max_ms = 2000 in NVS).
+
+Usage:
+    python3 tools/sampling_report.py trace.csv [--min-ms 2000] [--max-ms 300000]
+                                               [--temp-rate 50] [--hum-rate 200]
+                                               [--fixed-ms 10000 60000]
+"""
+
+import argparse
+import bisect
+import csv
+import math
+from datetime import datetime
+
+# Keep in sync with includes/sampling_manager.h and includes/common.h
+DHT_MIN_INTERVAL_MS = 2 * 1000
+MEASURE_INTERVAL_MS = 60 * 1000
+TEMP_DEADBAND = 0.15
+HUM_DEADBAND = 0.5
+
+
+def parse_time(value):
+    try:
+        return float(value)
+    except ValueError:
+        return datetime.strptime(value.strip(), "%Y-%m-%dT%H:%M:%SZ").timestamp()
+
+
+def load_trace(path):
+    rows = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            rows.append((parse_time(row["timestamp"]),
+                         float(row["temperature"]),
+                         float(row["humidity"])))
+    rows.sort()
+    if len(rows) < 2:
+        raise SystemExit("trace must contain at least two samples")
+    return rows
+
+
+def value_at(trace, times, t):
+    """Sample-and-hold: the sensor reports the latest recorded value."""
+    i = bisect.bisect_right(times, t) - 1
+    return trace[max(i, 0)]
+
+
+def reference_rate(ref, value, deadband, t):
+    """Model of reference_rate(); returns (rate, moved) and updates ref in place."""
+    elapsed_ms = max((t - ref[1]) * 1000.0, 1.0)
+    delta = abs(value - ref[0])
+    moved = delta >= deadband
+    if moved:
+        ref[0], ref[1] = value, t
+    else:
+        delta = deadband
+    return delta * 100.0 * 60000.0 / elapsed_ms, moved
+
+
+def adaptive_schedule(trace, min_ms, max_ms, temp_rate, hum_rate, intervals=None):
+    """Model of sampling_next_interval(); returns the sample instants."""
+    times = [r[0] for r in trace]
+    end = times[-1]
+    interval = min(max(MEASURE_INTERVAL_MS, min_ms), max_ms)
+    t = times[0]
+    taken = []
+    temp_ref = hum_ref = None
+    while t <= end:
+        _, temp, hum = value_at(trace, times, t)
+        taken.append(t)
+        if temp_ref is None:
+            temp_ref, hum_ref = [temp, t], [hum, t]
+        else:
+            tr, t_moved = reference_rate(temp_ref, temp, TEMP_DEADBAND, t)
+            hr, h_moved = reference_rate(hum_ref, hum, HUM_DEADBAND, t)
+            if (t_moved and tr > temp_rate) or (h_moved and hr > hum_rate):
+                interval = min_ms
+            elif 2.0 * tr < temp_rate and 2.0 * hr < hum_rate:
+                interval = max_ms if interval > max_ms // 2 else interval * 2
+        interval = min(max(interval, min_ms), max_ms)
+        if intervals is not None:
+            intervals.append(interval)
+        t += interval / 1000.0
+    return taken
+
+
+def fixed_schedule(trace, period_ms):
+    start, end = trace[0][0], trace[-1][0]
+    n = int((end - start) * 1000.0 // period_ms) + 1
+    return [start + k * period_ms / 1000.0 for k in range(n)]
+
+
+def reconstruction_error(trace, instants):
+    times = [r[0] for r in trace]
+    samples = [value_at(trace, times, t) for t in instants]
+    st = list(instants)
+
+    def interp(t, col):
+        j = bisect.bisect_right(st, t) - 1
+        if j < 0:
+            return samples[0][col]
+        if j >= len(st) - 1:
+            return samples[-1][col]
+        t0, t1 = st[j], st[j + 1]
+        v0, v1 = samples[j][col], samples[j + 1][col]
+        return v0 + (v1 - v0) * (t - t0) / (t1 - t0)
+
+    errors = {1: [], 2: []}
+    for t, temp, hum in trace:
+        errors[1].append(interp(t, 1) - temp)
+        errors[2].append(interp(t, 2) - hum)
+
+    def rms(e):
+        return math.sqrt(sum(x * x for x in e) / len(e))
+
+    return (rms(errors[1]), max(abs(x) for x in errors[1]),
+            rms(errors[2]), max(abs(x) for x in errors[2]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("trace", help="CSV trace with timestamp,temperature,humidity")
+    parser.add_argument("--min-ms", type=int, default=DHT_MIN_INTERVAL_MS)
+    parser.add_argument("--max-ms", type=int, default=5 * 60 * 1000)
+    parser.add_argument("--temp-rate", type=int, default=50, help="centi-degC per minute")
+    parser.add_argument("--hum-rate", type=int, default=200, help="centi-%% per minute")
+    parser.add_argument("--fixed-ms", type=int, nargs="*", default=[10 * 1000, MEASURE_INTERVAL_MS],
+                        help="fixed periods to compare against")
+    args = parser.parse_args()
+
+    if args.min_ms < DHT_MIN_INTERVAL_MS or args.max_ms < args.min_ms:
+        raise SystemExit("invalid bounds: need %d <= min-ms <= max-ms" % DHT_MIN_INTERVAL_MS)
+
+    trace = load_trace(args.trace)
+    duration_h = (trace[-1][0] - trace[0][0]) / 3600.0
+
+    schedules = [("fixed %d ms" % p, fixed_schedule(trace, p)) for p in args.fixed_ms]
+    schedules.append(("adaptive %d-%d ms" % (args.min_ms, args.max_ms),
+                      adaptive_schedule(trace, args.min_ms, args.max_ms,
+                                        args.temp_rate, args.hum_rate)))
+
+    print("Trace: %s, %d points, %.2f h" % (args.trace, len(trace), duration_h))
+    print("%-24s %9s %9s %10s %10s %10s %10s" %
+          ("schedule", "samples", "per hour", "T rms", "T max", "RH rms", "RH max"))
+    for name, instants in schedules:
+        t_rms, t_max, h_rms, h_max = reconstruction_error(trace, instants)
+        per_hour = len(instants) / duration_h if duration_h > 0 else float("nan")
+        print("%-24s %9d %9.1f %10.3f %10.3f %10.3f %10.3f" %
+              (name, len(instants), per_hour, t_rms, t_max, h_rms, h_max))
+
+
+if __name__ == "__main__":
+    main()
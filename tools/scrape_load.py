@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Concurrent scrape load test for the station metrics endpoint.
+
+Runs several scraper threads against /metrics and /metrics.json for a fixed
+duration and reports throughput, latency percentiles and errors. Every JSON
+response is parsed and every Prometheus response is checked line by line, so
+a torn or truncated buffer shows up as an error.
+
+Usage:
+    python3 tools/scrape_load.py http://192.168.1.50 --concurrency 8 --duration 30
+"""
+
+import argparse
+import http.client
+import json
+import statistics
+import threading
+import time
+from urllib.parse import urlparse
+
+PATHS = ("/metrics", "/metrics.json")
+
+
+def valid_prometheus(body):
+    for line in body.decode().splitlines():
+        if not line or line.startswith("#"):
+            continue
+        name, _, value = line.rpartition(" ")
+        if not name:
+            return False
+        float(value)
+    return True
+
+
+def valid_json(body):
+    doc = json.loads(body)
+    return "counters" in doc and "history" in doc
+
+
+def scraper(host, port, deadline, stats, lock):
+    conn = http.client.HTTPConnection(host, port, timeout=5)
+    i = 0
+    while time.perf_counter() < deadline:
+        path = PATHS[i % len(PATHS)]
+        i += 1
+        start = time.perf_counter()
+        try:
+            conn.request("GET", path)
+            resp = conn.getresponse()
+            body = resp.read()
+            ok = resp.status == 200 and (valid_json(body) if path.endswith(".json") else valid_prometheus(body))
+        except (OSError, ValueError, http.client.HTTPException):
+            ok = False
+            conn.close()
+            conn = http.client.HTTPConnection(host, port, timeout=5)
+        elapsed = time.perf_counter() - start
+        with lock:
+            if ok:
+                stats[path].append(elapsed)
+            else:
+                stats["errors"] += 1
+    conn.close()
+
+
+def percentile(values, pct):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * pct))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Concurrent scrapers for the metrics endpoint")
+    parser.add_argument("url", help="base URL of the station, e.g. http://192.168.1.50")
+    parser.add_argument("--concurrency", type=int, default=4)
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds")
+    args = parser.parse_args()
+
+    url = urlparse(args.url)
+    host, port = url.hostname, url.port or 80
+    stats = {path: [] for path in PATHS}
+    stats["errors"] = 0
+    lock = threading.Lock()
+    deadline = time.perf_counter() + args.duration
+
+    threads = [threading.Thread(target=scraper, args=(host, port, deadline, stats, lock))
+               for _ in range(args.concurrency)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    total = sum(len(stats[p]) for p in PATHS)
+    print("%d scrapers, %.1f s: %d ok, %d errors, %.1f req/s" %
+          (args.concurrency, args.duration, total, stats["errors"], total / args.duration))
+    print("%-14s %8s %9s %9s %9s" % ("path", "count", "p50 ms", "p95 ms", "p99 ms"))
+    for path in PATHS:
+        lat = stats[path]
+        if not lat:
+            print("%-14s %8d" % (path, 0))
+            continue
+        print("%-14s %8d %9.2f %9.2f %9.2f" %
+              (path, len(lat), statistics.median(lat) * 1000.0,
+               percentile(lat, 0.95) * 1000.0, percentile(lat, 0.99) * 1000.0))
+
+
+if __name__ == "__main__":
+    main()
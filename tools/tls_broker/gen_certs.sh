@@ -0,0 +1,34 @@
+#!/bin/sh
+# Creates a throwaway CA and a broker certificate for the local TLS broker.
+# The CA is also copied to main/certs/broker_ca.pem so it gets embedded in
+# the firmware at the next build.
+#
+# Usage: tools/tls_broker/gen_certs.sh <broker-ip-or-hostname>
+set -e
+
+if [ -z "$1" ]; then
+    echo "usage: $0 <broker-ip-or-hostname>" >&2
+    exit 1
+fi
+
+HOST="$1"
+DIR="$(cd "$(dirname "$0")" && pwd)"
+CERTS="$DIR/certs"
+mkdir -p "$CERTS" "$DIR/../../main/certs"
+
+openssl ecparam -name prime256v1 -genkey -noout -out "$CERTS/ca.key"
+openssl req -x509 -new -key "$CERTS/ca.key" -sha256 -days 365 \
+    -subj "/CN=iot_env_station test CA" -out "$CERTS/ca.pem"
+
+openssl ecparam -name prime256v1 -genkey -noout -out "$CERTS/broker.key"
+openssl req -new -key "$CERTS/broker.key" -subj "/CN=$HOST" -out "$CERTS/broker.csr"
+case "$HOST" in
+    *[!0-9.]*) SAN="DNS:$HOST" ;;
+    *) SAN="IP:$HOST" ;;
+esac
+printf "subjectAltName=%s\n" "$SAN" > "$CERTS/broker.ext"
+openssl x509 -req -in "$CERTS/broker.csr" -CA "$CERTS/ca.pem" -CAkey "$CERTS/ca.key" \
+    -CAcreateserial -sha256 -days 365 -extfile "$CERTS/broker.ext" -out "$CERTS/broker.pem"
+
+cp "$CERTS/ca.pem" "$DIR/../../main/certs/broker_ca.pem"
+echo "Certificates written to $CERTS"
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""
+Per-sample wire bytes and round-trip latency of the station transports.
+
+Publishes the same sample payload the firmware sends through:
+  udp             MQTT-SN style PUBLISH (QoS 1) to tools/mqttsn_gateway.py
+  tcp-per-sample  TCP connect + CONNECT + PUBLISH (QoS 1) + DISCONNECT, which is
+                  what a battery station waking up for every sample does
+  tcp-persistent  PUBLISH (QoS 1) over an already open MQTT connection
+
+Application bytes are counted exactly. Wire bytes add the IPv4/UDP/TCP
+headers using a simple packet model (one packet per message, 3 segments for
+the TCP handshake and 4 for the teardown, pure ACKs ignored), so the TCP
+figures are a lower bound. Round-trip time goes from the first byte sent to
+the acknowledgement, connection setup included.
+
+Usage:
+    python3 tools/transport_bench.py --gateway 127.0.0.1:10000 \\
+        --broker 127.0.0.1:1883 -n 200
+"""
+
+import argparse
+import socket
+import statistics
+import time
+
+import mqtt_wire
+
+IPV4_HEADER = 20
+UDP_HEADER = 8
+TCP_HEADER = 20
+TCP_SYN_OPTIONS = 20
+TCP_HANDSHAKE_SEGMENTS = 3
+TCP_TEARDOWN_SEGMENTS = 4
+
+# Keep in sync with includes/mqttsn_manager.h
+ACK_TIMEOUT_S = 0.3
+MAX_RETRIES = 2
+
+# create_json_payload() output with PSYCHRO_METRICS_ENABLED, for 23.5 degC and 45.2 %
+SAMPLE = (b'{"temperature":"23.50","humidity":"45.20","timestamp":"2025-06-19T10:45:00Z",'
+          b'"dew_point":"10.95","abs_humidity":"9.54","heat_index":"23.09"}')
+TOPIC = "/home/office/dht"
+
+
+class Result:
+    def __init__(self, name):
+        self.name = name
+        self.app_bytes = []
+        self.packets = []
+        self.wire_bytes = []
+        self.rtts = []
+        self.failed = 0
+
+    def add(self, app, packets, wire, rtt):
+        self.app_bytes.append(app)
+        self.packets.append(packets)
+        self.wire_bytes.append(wire)
+        self.rtts.append(rtt)
+
+
+def bench_udp(gateway, samples, topic_id):
+    result = Result("udp (MQTT-SN)")
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.connect(gateway)
+    for i in range(samples):
+        msg_id = i % 0xFFFF + 1
+        app = packets = 0
+        start = time.perf_counter()
+        acked = False
+        for attempt in range(MAX_RETRIES + 1):
+            packet = mqtt_wire.sn_publish(topic_id, SAMPLE, msg_id, qos1=True, dup=attempt > 0)
+            sock.send(packet)
+            app += len(packet)
+            packets += 1
+            deadline = time.perf_counter() + ACK_TIMEOUT_S
+            while not acked and time.perf_counter() < deadline:
+                sock.settimeout(max(deadline - time.perf_counter(), 0.001))
+                try:
+                    reply = sock.recv(64)
+                except socket.timeout:
+                    break
+                app += len(reply)
+                packets += 1
+                parsed = mqtt_wire.sn_parse(reply)
+                if parsed and parsed[0] == mqtt_wire.SN_PUBACK and parsed[1][2:4] == msg_id.to_bytes(2, "big"):
+                    acked = parsed[1][4] == mqtt_wire.SN_RC_ACCEPTED
+                    break
+            if acked:
+                break
+        rtt = time.perf_counter() - start
+        if not acked:
+            result.failed += 1
+            continue
+        result.add(app, packets, app + packets * (IPV4_HEADER + UDP_HEADER), rtt)
+    sock.close()
+    return result
+
+
+def mqtt_exchange(sock, msg_id):
+    """PUBLISH QoS 1 and wait for the PUBACK, returns (app_bytes, packets)."""
+    packet = mqtt_wire.publish(TOPIC, SAMPLE, qos=1, msg_id=msg_id)
+    sock.sendall(packet)
+    app, packets = len(packet), 1
+    while True:
+        ptype, body, length = mqtt_wire.read_packet(sock)
+        app += length
+        packets += 1
+        if ptype & 0xF0 == mqtt_wire.PUBACK and body[:2] == msg_id.to_bytes(2, "big"):
+            return app, packets
+
+
+def bench_tcp_per_sample(broker, samples):
+    result = Result("tcp per sample (MQTT)")
+    for i in range(samples):
+        start = time.perf_counter()
+        try:
+            sock = mqtt_wire.open_tcp(*broker)
+            connect = mqtt_wire.connect("iot_env_station_bench")
+            sock.sendall(connect)
+            ptype, body, connack_len = mqtt_wire.read_packet(sock)
+            if ptype != mqtt_wire.CONNACK or body[1] != 0:
+                raise ConnectionError("broker refused connection")
+            app, packets = mqtt_exchange(sock, i % 0xFFFF + 1)
+            rtt = time.perf_counter() - start
+            sock.sendall(mqtt_wire.disconnect())
+            sock.close()
+        except OSError:
+            result.failed += 1
+            continue
+        app += len(connect) + connack_len + 2
+        packets += 3
+        segments = packets + TCP_HANDSHAKE_SEGMENTS + TCP_TEARDOWN_SEGMENTS
+        wire = app + segments * (IPV4_HEADER + TCP_HEADER) + 2 * TCP_SYN_OPTIONS
+        result.add(app, segments, wire, rtt)
+    return result
+
+
+def bench_tcp_persistent(broker, samples):
+    result = Result("tcp persistent (MQTT)")
+    sock = mqtt_wire.open_tcp(*broker)
+    sock.sendall(mqtt_wire.connect("iot_env_station_bench"))
+    mqtt_wire.read_packet(sock)
+    for i in range(samples):
+        start = time.perf_counter()
+        try:
+            app, packets = mqtt_exchange(sock, i % 0xFFFF + 1)
+        except OSError:
+            result.failed += 1
+            continue
+        rtt = time.perf_counter() - start
+        result.add(app, packets, app + packets * (IPV4_HEADER + TCP_HEADER), rtt)
+    sock.sendall(mqtt_wire.disconnect())
+    sock.close()
+    return result
+
+
+def report(results):
+    print("payload: %d bytes" % len(SAMPLE))
+    print("%-24s %7s %7s %9s %9s %9s %9s %9s" %
+          ("transport", "ok", "failed", "app B", "packets", "wire B", "p50 ms", "p95 ms"))
+    for r in results:
+        if not r.rtts:
+            print("%-24s %7d %7d" % (r.name, 0, r.failed))
+            continue
+        rtts = sorted(r.rtts)
+        p95 = rtts[min(len(rtts) - 1, int(len(rtts) * 0.95))]
+        print("%-24s %7d %7d %9.1f %9.1f %9.1f %9.2f %9.2f" %
+              (r.name, len(r.rtts), r.failed,
+               statistics.mean(r.app_bytes), statistics.mean(r.packets),
+               statistics.mean(r.wire_bytes),
+               statistics.median(rtts) * 1000.0, p95 * 1000.0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare MQTT-SN/UDP and MQTT/TCP per-sample cost")
+    parser.add_argument("--gateway", default="127.0.0.1:10000", help="MQTT-SN gateway host:port")
+    parser.add_argument("--broker", default="127.0.0.1:1883", help="MQTT broker host:port")
+    parser.add_argument("--topic-id", type=int, default=1)
+    parser.add_argument("-n", "--samples", type=int, default=100)
+    args = parser.parse_args()
+
+    gateway = mqtt_wire.parse_hostport(args.gateway, 10000)
+    broker = mqtt_wire.parse_hostport(args.broker, 1883)
+    report([
+        bench_udp(gateway, args.samples, args.topic_id),
+        bench_tcp_per_sample(broker, args.samples),
+        bench_tcp_persistent(broker, args.samples),
+    ])
+
+
+if __name__ == "__main__":
+    main()